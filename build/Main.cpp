@@ -2,12 +2,16 @@
 #include "Example2.h"
 #include "Example3.h"
 #include "Example4.h"
+#include "Example5.h"
+#include "Example6.h"
+#include "Example7.h"
+#include "Example8.h"
 #include <iostream>
 
-enum class Example { Example1, Example2, Example3, Example4 };
+enum class Example { Example1, Example2, Example3, Example4, Example5, Example6, Example7, Example8 };
 
 // Set example to run:
-Example run = Example::Example4;
+Example run = Example::Example8;
 
 int main()
 {
@@ -25,6 +29,18 @@ int main()
     case Example::Example4:
         Example4().Run();
         break;
+    case Example::Example5:
+        Example5().Run();
+        break;
+    case Example::Example6:
+        Example6().Run();
+        break;
+    case Example::Example7:
+        Example7().Run();
+        break;
+    case Example::Example8:
+        Example8().Run();
+        break;
     }
 
     std::cout << std::endl << std::endl;
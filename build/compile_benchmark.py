@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+#
+# compile_benchmark.py
+#
+# Copyright (C) 2017 Daniel Nilsson
+#
+# This software may be modified and distributed under the terms
+# of the MIT license.  See the LICENSE file for details.
+#
+# Measures compile time and object size of a translation unit using XmlTree.h,
+# header only and with XMLTREE_COMPILED. The generated unit binds a struct with
+# one field per built-in value type for both elements and attributes, like a
+# typical converter file does.
+#
+#   python3 compile_benchmark.py [--cxx g++|clang++|cl] [--runs 5] [--fields 40]
+
+import argparse
+import os
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+TYPES = ["std::string", "bool", "float", "double", "uint16_t", "int16_t", "uint32_t", "int32_t", "uint64_t", "int64_t"]
+
+
+def generate(fields):
+    lines = ['#include "XmlTree.h"', "", "struct Record", "{"]
+    for i in range(fields):
+        lines.append("    %s f%d;" % (TYPES[i % len(TYPES)], i))
+    lines += ["};", "", "XMLTREE_REGISTER_CONVERTER(", "    void Convert(Element& e, Record& r)", "    {"]
+    for i in range(fields):
+        if i % 2 == 0:
+            lines.append('        e.Convert("f%d", r.f%d);' % (i, i))
+        else:
+            lines.append('        e.ConvertAttribute("f%d", r.f%d);' % (i, i))
+    lines += ["    }", ");", "",
+              "Record ParseRecord(const std::string& xml)", "{",
+              '    return XmlTree::Parse<Record>(xml, "record");', "}", ""]
+    return "\n".join(lines)
+
+
+def command(cxx, source, obj, includes, defines):
+    if os.path.basename(cxx).lower().startswith("cl"):
+        return ([cxx, "/nologo", "/c", "/EHsc", "/O2", "/std:c++14", source, "/Fo" + obj] +
+                ["/I" + i for i in includes] + ["/D" + d for d in defines])
+
+    return ([cxx, "-c", "-O2", "-std=c++14", source, "-o", obj] +
+            ["-I" + i for i in includes] + ["-D" + d for d in defines])
+
+
+def measure(cxx, source, obj, includes, defines, runs):
+    times = []
+    for _ in range(runs):
+        start = time.perf_counter()
+        subprocess.run(command(cxx, source, obj, includes, defines), check=True)
+        times.append(time.perf_counter() - start)
+
+    return statistics.median(times), os.path.getsize(obj)
+
+
+def main():
+    root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+    parser = argparse.ArgumentParser(description="Compile time and object size per translation unit.")
+    parser.add_argument("--cxx", default=os.environ.get("CXX", "c++"))
+    parser.add_argument("--tinyxml2", default=os.path.join(root, "src", "tinyxml2"))
+    parser.add_argument("--runs", type=int, default=5)
+    parser.add_argument("--fields", type=int, default=40)
+    args = parser.parse_args()
+
+    includes = [os.path.join(root, "include"), args.tinyxml2]
+    work = tempfile.mkdtemp()
+    try:
+        source = os.path.join(work, "record.cpp")
+        with open(source, "w") as f:
+            f.write(generate(args.fields))
+
+        print("%-14s %12s %12s" % ("mode", "time (s)", "object (B)"))
+        for mode, defines in (("header only", []), ("compiled", ["XMLTREE_COMPILED"])):
+            seconds, size = measure(args.cxx, source, os.path.join(work, "record.o"), includes, defines, args.runs)
+            print("%-14s %12.3f %12d" % (mode, seconds, size))
+
+        # the library side of compiled mode, built once per project
+        seconds, size = measure(args.cxx, os.path.join(root, "src", "XmlTree.cpp"), os.path.join(work, "XmlTree.o"),
+                                includes, ["XMLTREE_COMPILED"], args.runs)
+        print("%-14s %12.3f %12d" % ("XmlTree.cpp", seconds, size))
+    except subprocess.CalledProcessError as e:
+        sys.exit(e.returncode)
+    finally:
+        shutil.rmtree(work)
+
+
+if __name__ == "__main__":
+    main()
\ No newline at end of file
@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+#
+# memory_benchmark.py
+#
+# Copyright (C) 2017 Daniel Nilsson
+#
+# This software may be modified and distributed under the terms
+# of the MIT license.  See the LICENSE file for details.
+#
+# Measures peak resident memory of binding a large <notes> file with Read, which
+# holds the whole file and its DOM, against the streaming ReadRepeated and ReadEach.
+# Each mode runs in its own process, "baseline" only starts the process and is the
+# floor the others are measured from, "result" builds the same notes in memory
+# without any xml, the size of the bound result alone. POSIX only, peak memory is
+# taken from wait4.
+#
+#   python3 memory_benchmark.py [--cxx g++|clang++] [--notes 100000 400000]
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+DRIVER = r'''
+#include "XmlTree.h"
+#include "XmlTreeStream.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+struct Note
+{
+    uint32_t id;
+    std::string from;
+    std::string to;
+    std::string heading;
+    std::string body;
+
+    void Convert(XmlTree::Element& e)
+    {
+        e.ConvertAttribute("id", id);
+        e.Convert("from", from);
+        e.Convert("to", to);
+        e.Convert("heading", heading);
+        e.Convert("body", body);
+    }
+};
+
+struct Notes
+{
+    std::vector<Note> notes;
+
+    void Convert(XmlTree::Element& e)
+    {
+        e.ConvertRepeated("note", notes);
+    }
+};
+
+int main(int argc, char** argv)
+{
+    const char* mode = argv[1];
+    const std::string path = argv[2];
+
+    size_t count = 0;
+    if (std::strcmp(mode, "result") == 0)
+    {
+        std::vector<Note> notes;
+        for (size_t i = 0, n = std::strtoul(argv[3], nullptr, 10); i < n; ++i)
+        {
+            notes.push_back(Note{ static_cast<uint32_t>(i), "Luke Skywalker", "Leia Organa", "Reminder " + std::to_string(i),
+                "Don't forget to bring pizza tonight, and the droids as well!" });
+        }
+
+        count = notes.size();
+    }
+    else if (std::strcmp(mode, "read") == 0)
+    {
+        count = XmlTree::Read<Notes>(path, "notes").notes.size();
+    }
+    else if (std::strcmp(mode, "repeated") == 0)
+    {
+        std::vector<Note> notes;
+        XmlTree::ReadRepeated(path, "notes/note", notes);
+        count = notes.size();
+    }
+    else if (std::strcmp(mode, "each") == 0)
+    {
+        count = XmlTree::ReadEach<Note>(path, "notes/note", [](Note&) {});
+    }
+
+    std::printf("%zu\n", count);
+    return 0;
+}
+'''
+
+MODES = ["baseline", "result", "read", "repeated", "each"]
+
+
+def generate(path, notes):
+    with open(path, "w") as f:
+        f.write('<?xml version="1.0" encoding="utf-8"?>\n<notes>\n')
+        for i in range(notes):
+            f.write('\t<note id="%d">\n'
+                    '\t\t<from>Luke Skywalker</from>\n'
+                    '\t\t<to>Leia Organa</to>\n'
+                    '\t\t<heading>Reminder %d</heading>\n'
+                    '\t\t<body>Don\'t forget to bring pizza tonight, and the droids as well!</body>\n'
+                    '\t</note>\n' % (i, i))
+        f.write('</notes>\n')
+
+
+def build(cxx, work, includes, tinyxml2):
+    source = os.path.join(work, "driver.cpp")
+    with open(source, "w") as f:
+        f.write(DRIVER)
+
+    sources = [source]
+    library = os.path.join(tinyxml2, "tinyxml2.cpp")
+    if os.path.exists(library):
+        sources.append(library)
+
+    exe = os.path.join(work, "driver")
+    subprocess.run([cxx, "-O2", "-std=c++14", "-o", exe] + sources + ["-I" + i for i in includes], check=True)
+    return exe
+
+
+def peak_rss(exe, mode, path, notes):
+    proc = subprocess.Popen([exe, mode, path, str(notes)], stdout=subprocess.DEVNULL)
+    _, status, usage = os.wait4(proc.pid, 0)
+    proc.returncode = os.waitstatus_to_exitcode(status)
+    if proc.returncode != 0:
+        raise subprocess.CalledProcessError(proc.returncode, [exe, mode, path])
+
+    # kilobytes on Linux, bytes on macOS
+    return usage.ru_maxrss * (1 if sys.platform == "darwin" else 1024)
+
+
+def main():
+    root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+    parser = argparse.ArgumentParser(description="Peak memory of Read against the streaming readers.")
+    parser.add_argument("--cxx", default=os.environ.get("CXX", "c++"))
+    parser.add_argument("--tinyxml2", default=os.path.join(root, "src", "tinyxml2"))
+    parser.add_argument("--notes", type=int, nargs="+", default=[100000, 400000])
+    args = parser.parse_args()
+
+    includes = [os.path.join(root, "include"), args.tinyxml2]
+    work = tempfile.mkdtemp()
+    try:
+        exe = build(args.cxx, work, includes, args.tinyxml2)
+
+        print("%-10s %10s %-10s %14s %14s" % ("notes", "file (MB)", "mode", "peak (MB)", "over base (MB)"))
+        for notes in args.notes:
+            path = os.path.join(work, "notes.xml")
+            generate(path, notes)
+            size = os.path.getsize(path)
+
+            base = None
+            for mode in MODES:
+                peak = peak_rss(exe, mode, path, notes)
+                base = peak if base is None else base
+                print("%-10d %10.1f %-10s %14.1f %14.1f" % (notes, size / 1e6, mode, peak / 1e6, (peak - base) / 1e6))
+    except subprocess.CalledProcessError as e:
+        sys.exit(e.returncode)
+    finally:
+        shutil.rmtree(work)
+
+
+if __name__ == "__main__":
+    main()
\ No newline at end of file
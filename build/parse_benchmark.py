@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+#
+# parse_benchmark.py
+#
+# Copyright (C) 2017 Daniel Nilsson
+#
+# This software may be modified and distributed under the terms
+# of the MIT license.  See the LICENSE file for details.
+#
+# Measures throughput of XmlTree::Parse for each combination of Options on an
+# entity free <notes> document, the input Options::processEntities off is meant
+# for. Each configuration is parsed and bound repeatedly, best run is reported.
+#
+#   python3 parse_benchmark.py [--cxx g++|clang++|cl] [--notes 50000] [--runs 10]
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+DRIVER = r'''
+#include "XmlTree.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+struct Note
+{
+    uint32_t id;
+    std::string from;
+    std::string to;
+    std::string heading;
+    std::string body;
+
+    void Convert(XmlTree::Element& e)
+    {
+        e.ConvertAttribute("id", id);
+        e.Convert("from", from);
+        e.Convert("to", to);
+        e.Convert("heading", heading);
+        e.Convert("body", body);
+    }
+};
+
+struct Notes
+{
+    std::vector<Note> notes;
+
+    void Convert(XmlTree::Element& e)
+    {
+        e.ConvertRepeated("note", notes);
+    }
+};
+
+int main(int argc, char** argv)
+{
+    std::ifstream file(argv[1], std::ios::binary);
+    std::stringstream ss;
+    ss << file.rdbuf();
+    const std::string xml = ss.str();
+    const int runs = std::atoi(argv[2]);
+
+    struct Config { const char* name; bool processEntities; XmlTree::Whitespace whitespace; };
+    const Config configs[] =
+    {
+        { "entities, preserve", true, XmlTree::Whitespace::Preserve },
+        { "no entities, preserve", false, XmlTree::Whitespace::Preserve },
+        { "entities, collapse", true, XmlTree::Whitespace::Collapse },
+        { "no entities, collapse", false, XmlTree::Whitespace::Collapse },
+        { "entities, pedantic", true, XmlTree::Whitespace::Pedantic },
+        { "no entities, pedantic", false, XmlTree::Whitespace::Pedantic },
+    };
+
+    for (const auto& config : configs)
+    {
+        XmlTree::Options options;
+        options.processEntities = config.processEntities;
+        options.whitespace = config.whitespace;
+
+        double best = 0;
+        try
+        {
+            for (int i = 0; i < runs; ++i)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                const auto notes = XmlTree::Parse<Notes>(xml, "notes", options);
+                const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+                const double rate = xml.size() / 1e6 / elapsed.count();
+                best = rate > best && !notes.notes.empty() ? rate : best;
+            }
+
+            std::printf("%-24s %10.1f\n", config.name, best);
+        }
+        catch (std::runtime_error& e)
+        {
+            std::printf("%-24s %10s  %s\n", config.name, "-", e.what());
+        }
+    }
+
+    return 0;
+}
+'''
+
+
+def generate(notes):
+    lines = ['<?xml version="1.0" encoding="utf-8"?>', '<notes>']
+    for i in range(notes):
+        lines += ['\t<note id="%d">' % i,
+                  '\t\t<from>Luke Skywalker</from>',
+                  '\t\t<to>Leia Organa</to>',
+                  '\t\t<heading>Reminder %d</heading>' % i,
+                  '\t\t<body>Do not forget to bring pizza tonight, and the droids as well!</body>',
+                  '\t</note>']
+    lines.append('</notes>')
+    return "\n".join(lines)
+
+
+def build(cxx, work, includes, tinyxml2):
+    source = os.path.join(work, "driver.cpp")
+    with open(source, "w") as f:
+        f.write(DRIVER)
+
+    sources = [source]
+    library = os.path.join(tinyxml2, "tinyxml2.cpp")
+    if os.path.exists(library):
+        sources.append(library)
+
+    exe = os.path.join(work, "driver.exe" if sys.platform == "win32" else "driver")
+    if os.path.basename(cxx).lower().startswith("cl"):
+        subprocess.run([cxx, "/nologo", "/EHsc", "/O2", "/std:c++14", "/Fe" + exe, "/Fo" + work + os.sep] + sources +
+                       ["/I" + i for i in includes], check=True)
+    else:
+        subprocess.run([cxx, "-O2", "-std=c++14", "-o", exe] + sources + ["-I" + i for i in includes], check=True)
+
+    return exe
+
+
+def main():
+    root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+    parser = argparse.ArgumentParser(description="Parse throughput per Options on entity free input.")
+    parser.add_argument("--cxx", default=os.environ.get("CXX", "c++"))
+    parser.add_argument("--tinyxml2", default=os.path.join(root, "src", "tinyxml2"))
+    parser.add_argument("--notes", type=int, default=50000)
+    parser.add_argument("--runs", type=int, default=10)
+    args = parser.parse_args()
+
+    includes = [os.path.join(root, "include"), args.tinyxml2]
+    work = tempfile.mkdtemp()
+    try:
+        exe = build(args.cxx, work, includes, args.tinyxml2)
+
+        path = os.path.join(work, "notes.xml")
+        with open(path, "w") as f:
+            f.write(generate(args.notes))
+
+        print("%d notes, %.1f MB, best of %d runs" % (args.notes, os.path.getsize(path) / 1e6, args.runs))
+        print("%-24s %10s" % ("options", "MB/s"))
+        sys.stdout.flush()
+        subprocess.run([exe, path, str(args.runs)], check=True)
+    except subprocess.CalledProcessError as e:
+        sys.exit(e.returncode)
+    finally:
+        shutil.rmtree(work)
+
+
+if __name__ == "__main__":
+    main()
\ No newline at end of file
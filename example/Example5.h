@@ -0,0 +1,83 @@
+#include "XmlTree.h"
+#include <iostream>
+
+namespace Ex5Data
+{
+    enum class Priority { Low, Medium, High };
+
+    // Notes stored column wise instead of as a vector of structs,
+    // each field in its own contiguous container.
+    struct NoteColumns
+    {
+        std::vector<uint32_t> ids;
+        std::vector<Priority> priorities;
+        XmlTree::Columns::StringColumn froms;
+        XmlTree::Columns::StringColumn tos;
+        XmlTree::Columns::StringColumn headings;
+        XmlTree::Columns::StringColumn bodies;
+
+        void Convert(XmlTree::Element& e)
+        {
+            e.ConvertColumns("note",
+                XmlTree::AttributeColumn("id", ids),
+                XmlTree::ChildColumn("priority", priorities),
+                XmlTree::ChildColumn("from", froms),
+                XmlTree::ChildColumn("to", tos),
+                XmlTree::ChildColumn("heading", headings),
+                XmlTree::ChildColumnOptional("body", bodies, ""));
+        }
+    };
+}
+
+/**
+  Setup enum conversion between enum string and
+  value and register converter with xml-tree.
+
+  IMPORTANT: must be done in global namespace.
+*/
+XMLTREE_BEGIN_ENUM_CONVERTER(Ex5Data::Priority)
+  XMLTREE_MAP_ENUM(Ex5Data::Priority::Low, "Low")
+  XMLTREE_MAP_ENUM(Ex5Data::Priority::Medium, "Medium")
+  XMLTREE_MAP_ENUM(Ex5Data::Priority::High, "High")
+XMLTREE_END_ENUM_CONVERTER(Ex5Data::Priority)
+
+
+class Example5
+{
+public:
+    void Run()
+    {
+        try
+        {
+            auto notes = XmlTree::Read<Ex5Data::NoteColumns>("../example/data/notes.xml", "notes");
+
+            // scan a single column
+            size_t high = 0;
+            for (auto p : notes.priorities)
+            {
+                if (p == Ex5Data::Priority::High)
+                {
+                    ++high;
+                }
+            }
+
+            std::cout << notes.ids.size() << " notes, " << high << " with high priority" << std::endl << std::endl;
+            for (size_t i = 0; i < notes.ids.size(); ++i)
+            {
+                std::cout << "Note" << std::endl;
+                std::cout << "----------------------------------" << std::endl;
+                std::cout << "id:       " << notes.ids[i] << std::endl;
+                std::cout << "from:     " << notes.froms.Str(i) << std::endl;
+                std::cout << "to:       " << notes.tos.Str(i) << std::endl;
+                std::cout << "priority: " << XMLTREE_ENUM_TO_STRING(Ex5Data::Priority, notes.priorities[i]) << std::endl;
+                std::cout << "heading:  " << notes.headings.Str(i) << std::endl;
+                std::cout << "body:     " << notes.bodies.Str(i) << std::endl;
+                std::cout << std::endl;
+            }
+        }
+        catch (std::runtime_error& e)
+        {
+            std::cout << e.what() << std::endl;
+        }
+    }
+};
\ No newline at end of file
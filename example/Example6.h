@@ -0,0 +1,67 @@
+#include "XmlTree.h"
+#include <iostream>
+#include <unordered_map>
+
+namespace Ex6Data
+{
+    struct Note
+    {
+        std::string from;
+        std::string to;
+        std::string priority;
+        std::string heading;
+        std::string body;
+
+        void Convert(XmlTree::Element& e)
+        {
+            e.Convert("from", from);
+            e.Convert("to", to);
+            e.Convert("priority", priority);
+            e.Convert("heading", heading);
+            e.ConvertOptional("body", body, std::string(""));
+        }
+    };
+
+    struct Notes
+    {
+        // notes keyed by their id attribute, a sorted
+        // std::vector<std::pair<uint32_t, Note>> works the same way.
+        std::unordered_map<uint32_t, Note> notes;
+
+        void Convert(XmlTree::Element& e)
+        {
+            e.ConvertRepeated("note", XmlTree::KeyAttribute("id"), notes);
+        }
+    };
+}
+
+
+class Example6
+{
+public:
+    void Run()
+    {
+        try
+        {
+            auto notes = XmlTree::Read<Ex6Data::Notes>("../example/data/notes.xml", "notes");
+
+            auto& note = notes.notes.at(2566);
+
+            std::cout << "Note 2566" << std::endl;
+            std::cout << "----------------------------------" << std::endl;
+            std::cout << "from:     " << note.from << std::endl;
+            std::cout << "to:       " << note.to << std::endl;
+            std::cout << "priority: " << note.priority << std::endl;
+            std::cout << "heading:  " << note.heading << std::endl;
+            std::cout << "body:     " << note.body << std::endl;
+        }
+        catch (std::runtime_error& e)
+        {
+            std::cout << e.what() << std::endl;
+        }
+        catch (std::out_of_range& e)
+        {
+            std::cout << e.what() << std::endl;
+        }
+    }
+};
\ No newline at end of file
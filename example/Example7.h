@@ -0,0 +1,144 @@
+#include "XmlTreeStream.h"
+#include <iostream>
+#include <thread>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace Ex7Data
+{
+    struct Note
+    {
+        uint32_t id;
+        std::string from;
+
+        void Convert(XmlTree::Element& e)
+        {
+            e.ConvertAttribute("id", id);
+            e.Convert("from", from);
+        }
+    };
+
+    typedef XmlTree::MessageReader<Note> NoteReader;
+
+    // connected pair of descriptors, a pipe where socketpair is not available
+    inline bool OpenChannel(int fds[2])
+    {
+#ifdef _WIN32
+        return _pipe(fds, 4096, _O_BINARY) == 0;
+#else
+        return socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0;
+#endif
+    }
+
+    inline void WriteAll(int fd, const std::string& data)
+    {
+        for (size_t pos = 0; pos < data.size();)
+        {
+#ifdef _WIN32
+            int n = _write(fd, data.data() + pos, static_cast<unsigned>(data.size() - pos));
+#else
+            auto n = write(fd, data.data() + pos, data.size() - pos);
+#endif
+            if (n <= 0)
+            {
+                return;
+            }
+
+            pos += static_cast<size_t>(n);
+        }
+    }
+
+    inline void CloseChannel(int fd)
+    {
+#ifdef _WIN32
+        _close(fd);
+#else
+        close(fd);
+#endif
+    }
+
+    inline std::string Frame(const std::string& message, NoteReader::Framing framing)
+    {
+        if (framing == NoteReader::Framing::RootElement)
+        {
+            return message;
+        }
+
+        const auto length = static_cast<uint32_t>(message.size());
+        std::string prefix;
+        prefix += static_cast<char>(length >> 24);
+        prefix += static_cast<char>(length >> 16);
+        prefix += static_cast<char>(length >> 8);
+        prefix += static_cast<char>(length);
+        return prefix + message;
+    }
+}
+
+
+class Example7
+{
+public:
+    void Run()
+    {
+        Run(Ex7Data::NoteReader::Framing::RootElement, "root element framing");
+        std::cout << std::endl;
+        Run(Ex7Data::NoteReader::Framing::LengthPrefix, "length prefix framing");
+    }
+
+private:
+    // send three messages over a local socket, the second one does not bind, and
+    // read them back. The reader skips the bad message and continues with the next.
+    void Run(Ex7Data::NoteReader::Framing framing, const char* title)
+    {
+        std::cout << title << std::endl;
+        std::cout << "----------------------------------" << std::endl;
+
+        int fds[2];
+        if (!Ex7Data::OpenChannel(fds))
+        {
+            std::cout << "Failed to open channel." << std::endl;
+            return;
+        }
+
+        std::thread writer([fds, framing]()
+        {
+            Ex7Data::WriteAll(fds[0], Ex7Data::Frame("<note id=\"1\"><from>Luke Skywalker</from></note>", framing));
+            Ex7Data::WriteAll(fds[0], Ex7Data::Frame("<note id=\"bad\"><from>Darth Vader</from></note>", framing));
+            Ex7Data::WriteAll(fds[0], Ex7Data::Frame("<note id=\"3\"><from>Yoda</from></note>", framing));
+            Ex7Data::CloseChannel(fds[0]);
+        });
+
+        Ex7Data::NoteReader reader(fds[1], "note", framing);
+        Ex7Data::Note note;
+        Ex7Data::NoteReader::Message info;
+
+        for (;;)
+        {
+            try
+            {
+                if (!reader.Next(note, &info))
+                {
+                    break;
+                }
+
+                std::cout << "message " << info.index << ": id " << note.id << ", from " << note.from << ", " << info.bytes
+                    << " bytes, bound after " << std::chrono::duration_cast<std::chrono::microseconds>(info.latency).count() << " us" << std::endl;
+            }
+            catch (std::exception& e)
+            {
+                std::cout << "skipped: " << e.what() << std::endl;
+            }
+        }
+
+        std::cout << "end of stream" << std::endl;
+
+        writer.join();
+        Ex7Data::CloseChannel(fds[1]);
+    }
+};
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include "XmlTree.h"
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace Ex8Data
+{
+    enum class Priority { Low, Medium, High };
+
+    struct Note
+    {
+        uint32_t id;
+        std::string from;
+        std::string to;
+        Priority priority;
+        std::string heading;
+        std::string body;
+
+        void Convert(XmlTree::Element& e)
+        {
+            e.ConvertAttribute("id", id);
+            e.Convert("from", from);
+            e.Convert("to", to);
+            e.Convert("priority", priority);
+            e.Convert("heading", heading);
+            e.ConvertOptional("body", body, std::string(""));
+        }
+
+        bool operator==(const Note& other) const
+        {
+            return id == other.id && from == other.from && to == other.to &&
+                priority == other.priority && heading == other.heading && body == other.body;
+        }
+    };
+
+    struct Notes
+    {
+        std::vector<Note> notes;
+
+        void Convert(XmlTree::Element& e)
+        {
+            e.ConvertRepeated("note", notes);
+        }
+    };
+}
+
+XMLTREE_BEGIN_ENUM_CONVERTER(Ex8Data::Priority)
+  XMLTREE_MAP_ENUM(Ex8Data::Priority::Low, "Low")
+  XMLTREE_MAP_ENUM(Ex8Data::Priority::Medium, "Medium")
+  XMLTREE_MAP_ENUM(Ex8Data::Priority::High, "High")
+XMLTREE_END_ENUM_CONVERTER(Ex8Data::Priority)
+
+
+class Example8
+{
+public:
+    // many threads converting the same shared document at once, including the enum
+    // lookups which are built on first use by whichever thread gets there first.
+    void Run()
+    {
+        const unsigned threadCount = 8;
+        const unsigned iterations = 500;
+
+        try
+        {
+            auto doc = XmlTree::SharedDocument::Read("../example/data/notes.xml");
+
+            std::vector<Ex8Data::Notes> first(threadCount);
+            std::atomic<unsigned> mismatches(0);
+            std::atomic<unsigned> errors(0);
+            std::vector<std::thread> threads;
+
+            for (unsigned t = 0; t < threadCount; ++t)
+            {
+                threads.emplace_back([&doc, &first, &mismatches, &errors, t, iterations]()
+                {
+                    try
+                    {
+                        first[t] = doc.Convert<Ex8Data::Notes>("notes");
+
+                        for (unsigned i = 1; i < iterations; ++i)
+                        {
+                            auto notes = doc.Convert<Ex8Data::Notes>("notes");
+                            if (!(notes.notes == first[t].notes))
+                            {
+                                ++mismatches;
+                            }
+
+                            for (auto& note : notes.notes)
+                            {
+                                auto& str = XMLTREE_ENUM_TO_STRING(Ex8Data::Priority, note.priority);
+                                if (XMLTREE_ENUM_FROM_STRING(Ex8Data::Priority, str) != note.priority)
+                                {
+                                    ++mismatches;
+                                }
+                            }
+                        }
+                    }
+                    catch (std::runtime_error&)
+                    {
+                        ++errors;
+                    }
+                });
+            }
+
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+
+            for (unsigned t = 1; t < threadCount; ++t)
+            {
+                if (!(first[t].notes == first[0].notes))
+                {
+                    ++mismatches;
+                }
+            }
+
+            std::cout << "Shared document" << std::endl;
+            std::cout << "----------------------------------" << std::endl;
+            std::cout << "threads:     " << threadCount << std::endl;
+            std::cout << "conversions: " << threadCount * iterations << std::endl;
+            std::cout << "notes:       " << first[0].notes.size() << std::endl;
+            std::cout << "mismatches:  " << mismatches << std::endl;
+            std::cout << "errors:      " << errors << std::endl;
+        }
+        catch (std::runtime_error& e)
+        {
+            std::cout << e.what() << std::endl;
+        }
+    }
+};
\ No newline at end of file
@@ -12,11 +12,49 @@
 
 #include <string>
 #include <vector>
+#include <memory>
 #include <cstdint>
-#include <functional>
+#include <cstring>
 #include <algorithm>
-#include <sstream>
+#include <stdexcept>
 #include <type_traits>
+#include <tuple>
+#include <utility>
+
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#include <string_view>
+#define XMLTREE_HAS_STRING_VIEW
+#endif
+
+// Define XMLTREE_COMPILED project wide, for src/XmlTree.cpp as well as every file including
+// XmlTree.h, to compile the built-in value converters once in src/XmlTree.cpp instead of in
+// every translation unit. build/xml-tree.vcxproj and build/examples.vcxproj define it.
+#ifdef XMLTREE_COMPILED
+#define XMLTREE_INLINE
+#else
+#define XMLTREE_INLINE inline
+#endif
+
+#if !defined(XMLTREE_COMPILED) || defined(XMLTREE_IMPLEMENTATION)
+#include <cerrno>
+#include <cstdlib>
+#endif
+
+// built-in value types and the explicit instantiations of their conversion chain
+#define XMLTREE_FOR_EACH_VALUE_TYPE(X)                                          \
+    X(std::string) X(bool) X(float) X(double) X(uint16_t) X(int16_t)            \
+    X(uint32_t) X(int32_t) X(uint64_t) X(int64_t)
+
+#define XMLTREE_VALUE_CONVERTER_INSTANCE(Prefix, T)                             \
+    Prefix template void detail::call_convert(Element&, T&);                    \
+    Prefix template void detail::call_convert(Attribute&, T&);                  \
+    Prefix template void Converters::Convert<T>(Element&, T&);                  \
+    Prefix template void Converters::Convert<T>(Attribute&, T&);                \
+    Prefix template void Converters::Converter<T>::Convert(Element&, T&);       \
+    Prefix template void Converters::Converter<T>::Convert(Attribute&, T&);
+
+#define XMLTREE_EXTERN_VALUE_CONVERTER(T) XMLTREE_VALUE_CONVERTER_INSTANCE(extern, T)
+#define XMLTREE_INSTANTIATE_VALUE_CONVERTER(T) XMLTREE_VALUE_CONVERTER_INSTANCE(, T)
 
 #define XMLTREE_REGISTER_CONVERTER(f) namespace XmlTree { namespace Converters { template<> inline f }}
 
@@ -31,22 +69,22 @@ namespace XmlTree { namespace Enums
 
 #define XMLTREE_MAP_ENUM(EnumVal, Str) Register(EnumVal, Str);
 
-#define XMLTREE_END_ENUM_CONVERTER(EnumType)                    \
-        }                                                       \
-    };                                                          \
-}}                                                              \
-XMLTREE_REGISTER_CONVERTER(                                     \
-    void Convert(Element& e, EnumType& out)                     \
-    {                                                           \
-        out = XMLTREE_ENUM_FROM_STRING(EnumType, e.Value());    \
-    }                                                           \
-);                                                              \
-XMLTREE_REGISTER_CONVERTER(                                     \
-    void Convert(Attribute& e, EnumType& out)                   \
-    {                                                           \
-        out = XMLTREE_ENUM_FROM_STRING(EnumType, e.Value());    \
-    }                                                           \
-);
+#define XMLTREE_END_ENUM_CONVERTER(EnumType)                            \
+        }                                                               \
+    };                                                                  \
+}}                                                                      \
+namespace XmlTree { namespace Converters                                \
+{                                                                       \
+    template<>                                                          \
+    struct Converter<EnumType>                                          \
+    {                                                                   \
+        template<typename TSource>                                      \
+        static void Convert(TSource& source, EnumType& out)             \
+        {                                                               \
+            out = XMLTREE_ENUM_FROM_STRING(EnumType, source.Value());   \
+        }                                                               \
+    };                                                                  \
+}}
 
 #define XMLTREE_ENUM_TO_STRING(EnumType, EnumValue) XmlTree::Enums::EnumString<EnumType>::Str(EnumValue)
 #define XMLTREE_ENUM_FROM_STRING(EnumType, EnumStr) XmlTree::Enums::EnumString<EnumType>::Val(EnumStr)
@@ -60,10 +98,143 @@ namespace XmlTree
     class Attribute;
     namespace Converters
     {
+        // class counterpart of Convert, specialize it to register a converter for a family
+        // of types through partial specialization, e.g. all std::chrono::duration types.
+        template<typename T, typename Enable = void> struct Converter;
+
         template<typename T> void Convert(Element& a, T& out);
         template<typename T> void Convert(Attribute& a, T& out);
     }
 
+    // Name of element or attribute to look up, refers to the characters of the string it
+    // was created from without copying them. Created implicitly from string literals,
+    // const char*, std::string and std::string_view, or at compile time with "name"_xk.
+    // Only valid as long as those characters. Classes keeping a name beyond the call store their
+    // own copy, attribute bindings do not as they are only used within Element::ConvertAttributes.
+    class Key
+    {
+    public:
+        constexpr Key(const char* name)
+            : _data(name), _size(Length(name))
+        {
+        }
+
+        constexpr Key(const char* name, size_t size)
+            : _data(name), _size(size)
+        {
+        }
+
+        Key(const std::string& name)
+            : _data(name.data()), _size(name.size())
+        {
+        }
+
+#ifdef XMLTREE_HAS_STRING_VIEW
+        constexpr Key(std::string_view name)
+            : _data(name.data()), _size(name.size())
+        {
+        }
+#endif
+
+        constexpr const char* Data() const
+        {
+            return _data;
+        }
+
+        constexpr size_t Size() const
+        {
+            return _size;
+        }
+
+        std::string Str() const
+        {
+            return std::string(_data, _size);
+        }
+
+        // true if null terminated name equals key, rejects on first character before comparing the rest
+        bool Matches(const char* name) const
+        {
+            if (_size == 0)
+            {
+                return name[0] == '\0';
+            }
+
+            return name[0] == _data[0] && std::strncmp(name, _data, _size) == 0 && name[_size] == '\0';
+        }
+
+    private:
+        static constexpr size_t Length(const char* name)
+        {
+            size_t len = 0;
+            while (name[len] != '\0')
+            {
+                ++len;
+            }
+
+            return len;
+        }
+
+        const char* _data;
+        size_t _size;
+    };
+
+    inline namespace Literals
+    {
+        // key known at compile time, e.Convert("from"_xk, from)
+        constexpr Key operator"" _xk(const char* name, size_t size)
+        {
+            return Key(name, size);
+        }
+    }
+
+    namespace detail
+    {
+        // xml whitespace
+        inline bool is_space(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+        }
+
+        inline const tinyxml2::XMLElement* first_child(const tinyxml2::XMLElement* parent, const Key& name)
+        {
+            for (auto e = parent->FirstChildElement(); e != nullptr; e = e->NextSiblingElement())
+            {
+                if (name.Matches(e->Name()))
+                {
+                    return e;
+                }
+            }
+
+            return nullptr;
+        }
+
+        inline const tinyxml2::XMLElement* next_sibling(const tinyxml2::XMLElement* e, const Key& name)
+        {
+            for (e = e->NextSiblingElement(); e != nullptr; e = e->NextSiblingElement())
+            {
+                if (name.Matches(e->Name()))
+                {
+                    return e;
+                }
+            }
+
+            return nullptr;
+        }
+
+        inline const tinyxml2::XMLAttribute* find_attribute(const tinyxml2::XMLElement* e, const Key& name)
+        {
+            for (auto a = e->FirstAttribute(); a != nullptr; a = a->Next())
+            {
+                if (name.Matches(a->Name()))
+                {
+                    return a;
+                }
+            }
+
+            return nullptr;
+        }
+    }
+
     namespace detail
     {
         template<typename, typename T>
@@ -114,6 +285,92 @@ namespace XmlTree
         {
             convert_impl<detail::has_convert<TOut, void(TIn&)>::value>::convert(e, out);
         }
+
+        template<typename TFunc, typename... TArgs>
+        void for_each_arg(TFunc&& func, TArgs&... args)
+        {
+            int expand[] = { 0, (func(args), 0)... };
+            (void)expand;
+        }
+
+        template<typename TColumn> struct column_sink;
+
+        template<typename...> struct make_void { typedef void type; };
+        template<typename... T> using void_t = typename make_void<T...>::type;
+
+        template<typename T, typename = void>
+        struct has_reserve : std::false_type {};
+
+        template<typename T>
+        struct has_reserve<T, void_t<decltype(std::declval<T&>().reserve(size_t()))>> : std::true_type {};
+
+        template<typename T, typename = void>
+        struct is_associative : std::false_type {};
+
+        template<typename T>
+        struct is_associative<T, void_t<typename T::key_type, typename T::mapped_type>> : std::true_type {};
+
+        // fixed capacity containers report their capacity through max_size()
+        template<typename TContainer>
+        void reserve_sink(TContainer& out, size_t count, Key name, std::true_type)
+        {
+            if (count > out.max_size() - out.size())
+            {
+                throw std::runtime_error("Repeated element '" + name.Str() + "' has more entries than the container can hold.");
+            }
+
+            out.reserve(out.size() + count);
+        }
+
+        template<typename TContainer>
+        void reserve_sink(TContainer& out, size_t count, Key name, std::false_type)
+        {
+            if (count > out.max_size() - out.size())
+            {
+                throw std::runtime_error("Repeated element '" + name.Str() + "' has more entries than the container can hold.");
+            }
+        }
+
+        template<typename TContainer>
+        void reserve_sink(TContainer& out, size_t count, Key name)
+        {
+            reserve_sink(out, count, name, has_reserve<TContainer>());
+        }
+
+        template<typename TContainer, typename = void>
+        struct sequence_sink
+        {
+            // back() does not return a reference to value (std::vector<bool>), convert to temporary
+            template<typename TIn>
+            static void append(TContainer& out, TIn in)
+            {
+                typename TContainer::value_type value;
+                in.Convert(value);
+                out.push_back(std::move(value));
+            }
+        };
+
+        template<typename TContainer>
+        struct sequence_sink<TContainer, typename std::enable_if<
+            std::is_same<decltype(std::declval<TContainer&>().back()), typename TContainer::value_type&>::value>::type>
+        {
+            template<typename TIn>
+            static void append(TContainer& out, TIn in)
+            {
+                out.emplace_back();
+                try
+                {
+                    in.Convert(out.back());
+                }
+                catch (...)
+                {
+                    out.pop_back();
+                    throw;
+                }
+            }
+        };
+
+        template<typename TContainer, typename = void> struct keyed_sink;
     }
 
     template<typename T>
@@ -184,8 +441,16 @@ namespace XmlTree
             return _attribute->Value() == nullptr ? "" : _attribute->Value();
         }
 
+        // value of attribute as pointer into document, valid as long as document
+        // with Options::processEntities off this is the text exactly as written
+        const char* RawValue() const
+        {
+            return _attribute->Value() == nullptr ? "" : _attribute->Value();
+        }
+
+        // accepts temporary conversion targets, e.g. Convert(XmlTree::Base64(bytes))
         template<typename T>
-        void Convert(T& out)
+        void Convert(T&& out)
         {
             detail::call_convert(const_cast<Attribute&>(*this), out);
         }
@@ -194,6 +459,60 @@ namespace XmlTree
         const tinyxml2::XMLAttribute* _attribute;
     };
 
+    namespace detail
+    {
+        // walk attribute list once, matching each attribute against the binding names starting
+        // after the last match, so attributes bound in document order are found on the first compare.
+        // The bindings stay a parameter pack, a match is dispatched by index in a compile time loop.
+        template<typename... TBindings>
+        size_t bind_attributes(const tinyxml2::XMLElement* e, TBindings&... bindings)
+        {
+            const size_t count = sizeof...(TBindings);
+            const Key names[] = { bindings.Name()..., Key("") };
+            bool found[count + 1] = {};
+
+            size_t cursor = 0;
+            size_t bound = 0;
+            for (auto a = e->FirstAttribute(); a != nullptr && bound < count; a = a->Next())
+            {
+                for (size_t n = 0; n < count; ++n)
+                {
+                    const size_t index = cursor;
+                    cursor = cursor + 1 == count ? 0 : cursor + 1;
+
+                    if (!found[index] && names[index].Matches(a->Name()))
+                    {
+                        found[index] = true;
+                        ++bound;
+
+                        size_t i = 0;
+                        for_each_arg([&i, index, a](auto& binding) { if (i++ == index) binding.Convert(a); }, bindings...);
+                        break;
+                    }
+                }
+            }
+
+            std::string missing;
+            size_t i = 0;
+            for_each_arg([&](auto& binding)
+            {
+                if (!found[i] && !binding.Default())
+                {
+                    missing += (missing.empty() ? "'" : ", '") + names[i].Str() + "'";
+                }
+
+                ++i;
+            }, bindings...);
+
+            if (!missing.empty())
+            {
+                throw std::runtime_error("Element '" + std::string(e->Name()) + "' is missing required attributes " + missing + ".");
+            }
+
+            return bound;
+        }
+    }
+
     class Element
     {
     public:
@@ -214,37 +533,44 @@ namespace XmlTree
             return _element->GetText() == nullptr ? "" : _element->GetText();
         }
 
+        // value as pointer into document, valid as long as document
+        // with Options::processEntities off this is the text exactly as written
+        const char* RawValue() const
+        {
+            return _element->GetText() == nullptr ? "" : _element->GetText();
+        }
+
         // true if element has named attribute, false otherwise
-        bool HasAttribute(const std::string& name) const
+        bool HasAttribute(Key name) const
         {
-            return _element->FindAttribute(name.c_str()) != nullptr;
+            return detail::find_attribute(_element, name) != nullptr;
         }
 
         // get named attribute, throws exception if does not exist.
-        Attribute Attribute(const std::string& name) const
+        XmlTree::Attribute Attribute(Key name) const
         {
-            auto attrib = _element->FindAttribute(name.c_str());
+            auto attrib = detail::find_attribute(_element, name);
             if (attrib == nullptr)
             {
-                throw std::runtime_error("Element '" + Name() + "' does not have an attribute named '" + name + "'.");
+                throw std::runtime_error("Element '" + Name() + "' does not have an attribute named '" + name.Str() + "'.");
             }
 
             return XmlTree::Attribute(attrib);
         }
 
         // true if element has named child element, false otherwise
-        bool HasChild(const std::string& name) const
+        bool HasChild(Key name) const
         {
-            return _element->FirstChildElement(name.c_str()) != nullptr;
+            return detail::first_child(_element, name) != nullptr;
         }
 
         // get named child element, throws exception if does not exist.
-        Element Child(const std::string& name) const
+        Element Child(Key name) const
         {
-            auto elem = _element->FirstChildElement(name.c_str());
+            auto elem = detail::first_child(_element, name);
             if (elem == nullptr)
             {
-                throw std::runtime_error("Element '" + Name() + "' does not have a child named '" + name + "'.");
+                throw std::runtime_error("Element '" + Name() + "' does not have a child named '" + name.Str() + "'.");
             }
 
             return Element(elem);
@@ -253,139 +579,214 @@ namespace XmlTree
 
         // convert element itself to type, if element is of value type this will perform conversion of the value.
         template<typename T>
-        void Convert(T& out) const
+        void Convert(T&& out) const
         {
             detail::call_convert(const_cast<Element&>(*this), out);
         }
 
         // convert named child element to type
         template<typename T>
-        void Convert(const std::string& name, T& out) const
+        void Convert(Key name, T&& out) const
         {
-            if (!HasChild(name))
+            auto elem = detail::first_child(_element, name);
+            if (elem == nullptr)
             {
-                throw std::runtime_error("Required element '" + name + "' not found.");
+                throw std::runtime_error("Required element '" + name.Str() + "' not found.");
             }
 
-            Child(name).Convert(out);
+            Element(elem).Convert(out);
         }
 
         // convert optional named child element to type
         template<typename T>
-        bool ConvertOptional(const std::string& name, T& out, const T& defaultVal) const
+        bool ConvertOptional(Key name, T& out, const T& defaultVal) const
         {
-            if (!HasChild(name))
+            auto elem = detail::first_child(_element, name);
+            if (elem == nullptr)
             {
                 out = defaultVal;
                 return false;
             }
             
-            Child(name).Convert(out);
+            Element(elem).Convert(out);
             return true;
         }
 
         // convert optional named child element to type
         template<typename T>
-        bool ConvertOptional(const std::string& name, Optional<T>& out) const
+        bool ConvertOptional(Key name, Optional<T>& out) const
         {
-            if (!HasChild(name))
+            auto elem = detail::first_child(_element, name);
+            if (elem == nullptr)
             {
                 out.Reset();
                 return false;
             }
 
             out.HasValue(true);
-            Child(name).Convert(out.Value());
+            Element(elem).Convert(out.Value());
             return true;
         }
 
         // convert named attribute to type
         template<typename T>
-        void ConvertAttribute(const std::string& name, T& out) const
+        void ConvertAttribute(Key name, T&& out) const
         {
-            if (!HasAttribute(name))
+            auto attrib = detail::find_attribute(_element, name);
+            if (attrib == nullptr)
             {
-                throw std::runtime_error("Required attribute '" + name + "' not found.");
+                throw std::runtime_error("Required attribute '" + name.Str() + "' not found.");
             }
 
-            Attribute(name).Convert(out);
+            XmlTree::Attribute(attrib).Convert(out);
         }
 
         // convert optional named attribute to type
         template<typename T>
-        bool ConvertAttributeOptional(const std::string& name, T& out, const T& defaultVal) const
+        bool ConvertAttributeOptional(Key name, T& out, const T& defaultVal) const
         {
-            if (!HasAttribute(name))
+            auto attrib = detail::find_attribute(_element, name);
+            if (attrib == nullptr)
             {
                 out = defaultVal;
                 return false;
             }
             
-            Attribute(name).Convert(out);
+            XmlTree::Attribute(attrib).Convert(out);
             return true;
         }
 
         // convert optional named attribute to type
         template<typename T>
-        bool ConvertAttributeOptional(const std::string& name, Optional<T>& out) const
+        bool ConvertAttributeOptional(Key name, Optional<T>& out) const
         {
-            if (!HasAttribute(name))
+            auto attrib = detail::find_attribute(_element, name);
+            if (attrib == nullptr)
             {
                 out.Reset();
                 return false;
             }
 
             out.HasValue(true);
-            Attribute(name).Convert(out.Value());
+            XmlTree::Attribute(attrib).Convert(out.Value());
             return true;
         }
 
-        // convert named list of elements to vector of type
-        template<typename T>
-        void ConvertList(const std::string& listName, const std::string& elemName, std::vector<T>& out) const
+        // convert several attributes in a single pass over the attribute list. Bindings are
+        // created with AttributeBinding(name, out) and AttributeBindingOptional(name, out, default)
+        // directly in the call, unknown attributes are ignored. Throws listing every missing required attribute,
+        // returns number of attributes found.
+        template<typename... TBindings>
+        size_t ConvertAttributes(TBindings&&... bindings) const
+        {
+            return detail::bind_attributes(_element, bindings...);
+        }
+
+        // convert named list of elements to container of type
+        template<typename TContainer>
+        void ConvertList(Key listName, Key elemName, TContainer& out) const
         {
             if (!HasChild(listName))
             {
-                throw std::runtime_error("Required list '" + listName + "' not found.");
+                throw std::runtime_error("Required list '" + listName.Str() + "' not found.");
             }
 
             ConvertListOptional(listName, elemName, out);
         }
 
-        // convert optional named list of elements to vector of type
-        template<typename T>
-        bool ConvertListOptional(const std::string& listName, const std::string& elemName, std::vector<T>& out) const
+        // convert optional named list of elements to container of type
+        template<typename TContainer>
+        bool ConvertListOptional(Key listName, Key elemName, TContainer& out) const
         {
             if (!HasChild(listName))
             {
                 return false;
             }
 
-            auto list = _element->FirstChildElement(listName.c_str());
-            for (auto e = list->FirstChildElement(elemName.c_str()); e != nullptr; e = e->NextSiblingElement(elemName.c_str()))
+            Child(listName).ConvertRepeated(elemName, out);
+            return true;
+        }
+
+        // convert named list of elements to keyed container, see ConvertRepeated
+        template<typename TKey, typename TContainer>
+        void ConvertList(Key listName, Key elemName, const TKey& key, TContainer& out) const
+        {
+            if (!HasChild(listName))
+            {
+                throw std::runtime_error("Required list '" + listName.Str() + "' not found.");
+            }
+
+            ConvertListOptional(listName, elemName, key, out);
+        }
+
+        // convert optional named list of elements to keyed container, see ConvertRepeated
+        template<typename TKey, typename TContainer>
+        bool ConvertListOptional(Key listName, Key elemName, const TKey& key, TContainer& out) const
+        {
+            if (!HasChild(listName))
             {
-                T i;
-                Element(e).Convert(i);
-                out.push_back(i);
+                return false;
             }
 
+            Child(listName).ConvertRepeated(elemName, key, out);
             return true;
         }
 
-        // convert named repeated element to vector of type
-        template<typename T>
-        void ConvertRepeated(const std::string& name, std::vector<T>& out) const
+        // convert named repeated element to container of type, any container with
+        // emplace_back() and back() will do, values are converted in place.
+        template<typename TContainer>
+        void ConvertRepeated(Key name, TContainer& out) const
+        {
+            detail::reserve_sink(out, CountRepeated(name), name);
+
+            for (auto e = detail::first_child(_element, name); e != nullptr; e = detail::next_sibling(e, name))
+            {
+                detail::sequence_sink<TContainer>::append(out, Element(e));
+            }
+        }
+
+        // convert named repeated element to keyed container, key is extracted from each element
+        // by KeyAttribute(name), KeyChild(name) or a callable taking an Element.
+        //
+        // Associative containers (map, unordered_map...) get values constructed in place under their key.
+        // Sequences of pairs (e.g. std::vector<std::pair<K, V>>) are sorted by key once after binding,
+        // forming a flat map, left unchanged if a row fails or a key is duplicated. Duplicate keys throw.
+        template<typename TKey, typename TContainer>
+        void ConvertRepeated(Key name, const TKey& key, TContainer& out) const
         {
-            for (auto e = _element->FirstChildElement(name.c_str()); e != nullptr; e = e->NextSiblingElement(name.c_str()))
+            detail::keyed_sink<TContainer>::convert(_element, name, key, out, CountRepeated(name));
+        }
+
+        // convert named repeated element into columns, one contiguous container per field,
+        // returns number of rows appended. Columns are created with ChildColumn/AttributeColumn.
+        // If a row fails all columns are truncated to their size before the call and the error is rethrown.
+        template<typename... TColumns>
+        size_t ConvertColumns(Key name, TColumns&&... columns) const
+        {
+            size_t rows = CountRepeated(name);
+            detail::for_each_arg([rows](auto& column) { column.Reserve(rows); }, columns...);
+
+            const size_t start[] = { 0, columns.Rows()... };
+            try
+            {
+                for (auto e = detail::first_child(_element, name); e != nullptr; e = detail::next_sibling(e, name))
+                {
+                    detail::for_each_arg([e](auto& column) { column.Append(e); }, columns...);
+                }
+            }
+            catch (...)
             {
-                T i;
-                Element(e).Convert(i);
-                out.push_back(i);
+                size_t i = 0;
+                detail::for_each_arg([&start, &i](auto& column) { column.Truncate(start[++i]); }, columns...);
+                throw;
             }
+
+            return rows;
         }
 
         // loop over all child elements and do custom processing
-        void ForEachElement(std::function<void(Element& e)> func) const
+        template<typename TFunc>
+        void ForEachElement(TFunc&& func) const
         {
             for (auto e = _element->FirstChildElement(); e != nullptr; e = e->NextSiblingElement())
             {
@@ -395,9 +796,10 @@ namespace XmlTree
         }
 
         // loop over all attributes on element and do custom processing
-        void ForEachAttribute(std::function<void(XmlTree::Attribute& a)> func) const
+        template<typename TFunc>
+        void ForEachAttribute(TFunc&& func) const
         {
-            for (auto a = _element->FirstAttribute(); a != nullptr; a->Next())
+            for (auto a = _element->FirstAttribute(); a != nullptr; a = a->Next())
             {
                 XmlTree::Attribute tmp(a);
                 func(tmp);
@@ -405,219 +807,1114 @@ namespace XmlTree
         }
 
     private:
+        size_t CountRepeated(Key name) const
+        {
+            size_t count = 0;
+            for (auto e = detail::first_child(_element, name); e != nullptr; e = detail::next_sibling(e, name))
+            {
+                ++count;
+            }
+
+            return count;
+        }
+
         const tinyxml2::XMLElement* _element;
     };
 
 
-    namespace Enums
+    namespace Keys
     {
-        template<typename TDerived, typename TEnum>
-        struct EnumStringBase
+        // key taken from named attribute of element
+        class AttributeKey
         {
         public:
-            static const std::string& Str(TEnum e)
+            explicit AttributeKey(Key name)
+                : _name(name.Str())
             {
-                auto& map = Map();
-
-                auto itr = std::find_if(map.begin(), map.end(), 
-                    [&](const std::pair<TEnum, std::string>& pair)
-                    {
-                        return pair.first == e;
-                    });
-
-                if (itr != map.end())
-                {
-                    return itr->second;
-                }
-
-                throw std::runtime_error("'" + std::to_string(static_cast<int>(e)) + "' is not a valid value for enum and cannot be converted to string.");
             }
 
-            static TEnum Val(const std::string& str)
+            template<typename TKey>
+            void Extract(const Element& e, TKey& key) const
             {
-                auto& map = Map();
-
-                auto itr = std::find_if(map.begin(), map.end(),
-                    [&](const std::pair<TEnum, std::string>& pair)
-                    {
-                        return pair.second == str;
-                    });
-
-                if (itr != map.end())
-                {
-                    return itr->first;
-                }
-
-                throw std::runtime_error("'" + str + "' cannot be converted to a valid enum value.");
+                e.ConvertAttribute(_name, key);
             }
-            
-        protected:
-            using EnumMap = std::vector<std::pair<TEnum, std::string>>;
-
-            static EnumMap& Map()
-            {
-                static EnumMap map;
-                static bool first = true;
 
-                if (first)
-                {
-                    first = false;
-                    TDerived::RegisterAll();
-                }
+        private:
+            std::string _name;
+        };
 
-                return map;
+        // key taken from named child element of element
+        class ChildKey
+        {
+        public:
+            explicit ChildKey(Key name)
+                : _name(name.Str())
+            {
             }
 
-            static void Register(TEnum e, const std::string str)
+            template<typename TKey>
+            void Extract(const Element& e, TKey& key) const
             {
-                auto& map = Map();
-                map.push_back(std::pair<TEnum, std::string>(e, str ));
+                e.Convert(_name, key);
             }
-        };
 
-        template<typename TEnum>
-        struct EnumString : public EnumStringBase<EnumString<TEnum>, TEnum>
-        {
-            static void RegisterAll() { /* static_assert(false, "Enum type not registered with XmlTree."); */ }
+        private:
+            std::string _name;
         };
     }
 
-    namespace Converters
+    // key for ConvertRepeated/ConvertList taken from named attribute
+    inline Keys::AttributeKey KeyAttribute(Key name)
     {
-        // elements
-        
-        template<>
-        inline void Convert<std::string>(Element& e, std::string& out)
+        return Keys::AttributeKey(name);
+    }
+
+    // key for ConvertRepeated/ConvertList taken from named child element
+    inline Keys::ChildKey KeyChild(Key name)
+    {
+        return Keys::ChildKey(name);
+    }
+
+    namespace detail
+    {
+        template<typename TSpec, typename TKey>
+        auto extract_key(const TSpec& spec, const Element& e, TKey& key, int) -> decltype(spec.Extract(e, key), void())
         {
-            out = e.Value();
+            spec.Extract(e, key);
         }
 
-        template<>
-        inline void Convert<bool>(Element& e, bool& out)
+        template<typename TSpec, typename TKey>
+        void extract_key(const TSpec& spec, const Element& e, TKey& key, long)
         {
-            out = false;
-            std::istringstream(e.Value()) >> std::boolalpha >> out;
+            key = spec(e);
         }
 
-        template<>
-        inline void Convert<float>(Element& a, float& out)
+        template<typename TIterator>
+        TIterator emplaced_iterator(const std::pair<TIterator, bool>& res)
         {
-            out = std::stof(a.Value());
+            return res.first;
         }
 
-        template<>
-        inline void Convert<double>(Element& a, double& out)
+        template<typename TIterator>
+        TIterator emplaced_iterator(const TIterator& res)
         {
-            out = std::stod(a.Value());
+            return res;
         }
 
-        template<>
-        inline void Convert<uint16_t>(Element& e, uint16_t& out)
+        template<typename TIterator>
+        bool emplaced(const std::pair<TIterator, bool>& res)
         {
-            out = static_cast<uint16_t>(std::stoul(e.Value()));
+            return res.second;
         }
 
-        template<>
-        inline void Convert<int16_t>(Element& e, int16_t& out)
+        template<typename TIterator>
+        bool emplaced(const TIterator&)
         {
-            out = static_cast<int16_t>(std::stol(e.Value()));
+            return true;
         }
 
-        template<>
-        inline void Convert<uint32_t>(Element& a, uint32_t& out)
+        // map like containers, values constructed in place under their key
+        template<typename TContainer>
+        struct keyed_sink<TContainer, typename std::enable_if<is_associative<TContainer>::value>::type>
+        {
+            template<typename TKeySpec>
+            static void convert(const tinyxml2::XMLElement* parent, Key name, const TKeySpec& spec, TContainer& out, size_t count)
+            {
+                reserve_sink(out, count, name);
+
+                for (auto e = detail::first_child(parent, name); e != nullptr; e = detail::next_sibling(e, name))
+                {
+                    Element elem(e);
+
+                    typename TContainer::key_type key;
+                    extract_key(spec, elem, key, 0);
+
+                    auto res = out.emplace(std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::forward_as_tuple());
+                    if (!emplaced(res))
+                    {
+                        throw std::runtime_error("Duplicate key in repeated element '" + name.Str() + "'.");
+                    }
+
+                    auto itr = emplaced_iterator(res);
+                    try
+                    {
+                        elem.Convert(itr->second);
+                    }
+                    catch (...)
+                    {
+                        out.erase(itr);
+                        throw;
+                    }
+                }
+            }
+        };
+
+        // true if two sorted ranges have an element in common
+        template<typename TIterator, typename TLess>
+        bool sorted_ranges_intersect(TIterator a, TIterator aEnd, TIterator b, TIterator bEnd, TLess less)
         {
-            out = std::stoul(a.Value());
+            while (a != aEnd && b != bEnd)
+            {
+                if (less(*a, *b))
+                {
+                    ++a;
+                }
+                else if (less(*b, *a))
+                {
+                    ++b;
+                }
+                else
+                {
+                    return true;
+                }
+            }
+
+            return false;
         }
 
+        // sequence of key/value pairs, sorted by key after binding to form a flat map.
+        // On any error the appended rows are removed, leaving out as it was before the call.
+        template<typename TContainer>
+        struct keyed_sink<TContainer, typename std::enable_if<!is_associative<TContainer>::value>::type>
+        {
+            template<typename TKeySpec>
+            static void convert(const tinyxml2::XMLElement* parent, Key name, const TKeySpec& spec, TContainer& out, size_t count)
+            {
+                typedef typename TContainer::value_type Pair;
+
+                reserve_sink(out, count, name);
+                const auto sorted = out.size();
+
+                auto less = [](const Pair& a, const Pair& b) { return a.first < b.first; };
+
+                try
+                {
+                    for (auto e = detail::first_child(parent, name); e != nullptr; e = detail::next_sibling(e, name))
+                    {
+                        Element elem(e);
+
+                        out.emplace_back();
+                        extract_key(spec, elem, out.back().first, 0);
+                        elem.Convert(out.back().second);
+                    }
+
+                    auto mid = out.begin() + sorted;
+                    std::sort(mid, out.end(), less);
+
+                    // duplicates among the new rows, then between new and existing rows
+                    auto dup = std::adjacent_find(mid, out.end(),
+                        [](const Pair& a, const Pair& b) { return !(a.first < b.first); });
+
+                    if (dup != out.end() || sorted_ranges_intersect(out.begin(), mid, mid, out.end(), less))
+                    {
+                        throw std::runtime_error("Duplicate key in repeated element '" + name.Str() + "'.");
+                    }
+                }
+                catch (...)
+                {
+                    out.erase(out.begin() + sorted, out.end());
+                    throw;
+                }
+
+                std::inplace_merge(out.begin(), out.begin() + sorted, out.end(), less);
+            }
+        };
+    }
+
+    namespace Columns
+    {
+        // column of strings packed back to back in a single buffer,
+        // value i is the byte range [Offsets()[i], Offsets()[i + 1]) of Bytes().
+        class StringColumn
+        {
+        public:
+            StringColumn()
+                : _offsets(1, 0)
+            {
+            }
+
+            // number of values in column
+            size_t Size() const
+            {
+                return _offsets.size() - 1;
+            }
+
+            // pointer to first byte of value, not null terminated
+            const char* Data(size_t i) const
+            {
+                return _bytes.data() + _offsets[i];
+            }
+
+            // length of value in bytes
+            size_t Length(size_t i) const
+            {
+                return _offsets[i + 1] - _offsets[i];
+            }
+
+            // copy of value
+            std::string Str(size_t i) const
+            {
+                return std::string(Data(i), Length(i));
+            }
+
+            const std::vector<size_t>& Offsets() const
+            {
+                return _offsets;
+            }
+
+            const std::string& Bytes() const
+            {
+                return _bytes;
+            }
+
+            void Reserve(size_t values)
+            {
+                _offsets.reserve(_offsets.size() + values);
+            }
+
+            void Append(const char* str)
+            {
+                if (str != nullptr)
+                {
+                    _bytes.append(str);
+                }
+
+                _offsets.push_back(_bytes.size());
+            }
+
+            void Append(const std::string& str)
+            {
+                _bytes.append(str);
+                _offsets.push_back(_bytes.size());
+            }
+
+            // remove values from index rows and up
+            void Truncate(size_t rows)
+            {
+                if (rows < Size())
+                {
+                    _offsets.resize(rows + 1);
+                    _bytes.resize(_offsets.back());
+                }
+            }
+
+            void Clear()
+            {
+                _offsets.assign(1, 0);
+                _bytes.clear();
+            }
+
+        private:
+            std::vector<size_t> _offsets;
+            std::string _bytes;
+        };
+
+        // binds named child element of each row to column
+        template<typename TColumn>
+        class ChildColumn
+        {
+        public:
+            ChildColumn(Key name, TColumn& out)
+                : _name(name.Str()), _out(out)
+            {
+            }
+
+            void Reserve(size_t rows)
+            {
+                detail::column_sink<TColumn>::reserve(_out, rows);
+            }
+
+            size_t Rows() const
+            {
+                return detail::column_sink<TColumn>::size(_out);
+            }
+
+            void Truncate(size_t rows)
+            {
+                detail::column_sink<TColumn>::truncate(_out, rows);
+            }
+
+            void Append(const tinyxml2::XMLElement* row)
+            {
+                auto e = detail::first_child(row, _name);
+                if (e == nullptr)
+                {
+                    throw std::runtime_error("Required element '" + _name + "' not found.");
+                }
+
+                detail::column_sink<TColumn>::append(_out, e);
+            }
+
+        private:
+            std::string _name;
+            TColumn& _out;
+        };
+
+        // binds optional named child element of each row to column
+        template<typename TColumn, typename TValue>
+        class ChildColumnOptional
+        {
+        public:
+            ChildColumnOptional(Key name, TColumn& out, const TValue& defaultVal)
+                : _name(name.Str()), _out(out), _default(defaultVal)
+            {
+            }
+
+            void Reserve(size_t rows)
+            {
+                detail::column_sink<TColumn>::reserve(_out, rows);
+            }
+
+            size_t Rows() const
+            {
+                return detail::column_sink<TColumn>::size(_out);
+            }
+
+            void Truncate(size_t rows)
+            {
+                detail::column_sink<TColumn>::truncate(_out, rows);
+            }
+
+            void Append(const tinyxml2::XMLElement* row)
+            {
+                auto e = detail::first_child(row, _name);
+                if (e == nullptr)
+                {
+                    detail::column_sink<TColumn>::append_default(_out, _default);
+                    return;
+                }
+
+                detail::column_sink<TColumn>::append(_out, e);
+            }
+
+        private:
+            std::string _name;
+            TColumn& _out;
+            TValue _default;
+        };
+
+        // binds named attribute of each row to column
+        template<typename TColumn>
+        class AttributeColumn
+        {
+        public:
+            AttributeColumn(Key name, TColumn& out)
+                : _name(name.Str()), _out(out)
+            {
+            }
+
+            void Reserve(size_t rows)
+            {
+                detail::column_sink<TColumn>::reserve(_out, rows);
+            }
+
+            size_t Rows() const
+            {
+                return detail::column_sink<TColumn>::size(_out);
+            }
+
+            void Truncate(size_t rows)
+            {
+                detail::column_sink<TColumn>::truncate(_out, rows);
+            }
+
+            void Append(const tinyxml2::XMLElement* row)
+            {
+                auto a = detail::find_attribute(row, _name);
+                if (a == nullptr)
+                {
+                    throw std::runtime_error("Required attribute '" + _name + "' not found.");
+                }
+
+                detail::column_sink<TColumn>::append(_out, a);
+            }
+
+        private:
+            std::string _name;
+            TColumn& _out;
+        };
+
+        // binds optional named attribute of each row to column
+        template<typename TColumn, typename TValue>
+        class AttributeColumnOptional
+        {
+        public:
+            AttributeColumnOptional(Key name, TColumn& out, const TValue& defaultVal)
+                : _name(name.Str()), _out(out), _default(defaultVal)
+            {
+            }
+
+            void Reserve(size_t rows)
+            {
+                detail::column_sink<TColumn>::reserve(_out, rows);
+            }
+
+            size_t Rows() const
+            {
+                return detail::column_sink<TColumn>::size(_out);
+            }
+
+            void Truncate(size_t rows)
+            {
+                detail::column_sink<TColumn>::truncate(_out, rows);
+            }
+
+            void Append(const tinyxml2::XMLElement* row)
+            {
+                auto a = detail::find_attribute(row, _name);
+                if (a == nullptr)
+                {
+                    detail::column_sink<TColumn>::append_default(_out, _default);
+                    return;
+                }
+
+                detail::column_sink<TColumn>::append(_out, a);
+            }
+
+        private:
+            std::string _name;
+            TColumn& _out;
+            TValue _default;
+        };
+    }
+
+    namespace detail
+    {
+        template<typename T, typename TAlloc>
+        struct column_sink<std::vector<T, TAlloc>>
+        {
+            static void reserve(std::vector<T, TAlloc>& column, size_t rows)
+            {
+                column.reserve(column.size() + rows);
+            }
+
+            static size_t size(const std::vector<T, TAlloc>& column)
+            {
+                return column.size();
+            }
+
+            static void truncate(std::vector<T, TAlloc>& column, size_t rows)
+            {
+                if (rows < column.size())
+                {
+                    column.erase(column.begin() + rows, column.end());
+                }
+            }
+
+            static void append(std::vector<T, TAlloc>& column, const tinyxml2::XMLElement* e)
+            {
+                T value;
+                Element(e).Convert(value);
+                column.push_back(std::move(value));
+            }
+
+            static void append(std::vector<T, TAlloc>& column, const tinyxml2::XMLAttribute* a)
+            {
+                T value;
+                Attribute(a).Convert(value);
+                column.push_back(std::move(value));
+            }
+
+            static void append_default(std::vector<T, TAlloc>& column, const T& value)
+            {
+                column.push_back(value);
+            }
+        };
+
         template<>
-        inline void Convert<int32_t>(Element& a, int32_t& out)
+        struct column_sink<Columns::StringColumn>
         {
-            out = std::stol(a.Value());
+            static void reserve(Columns::StringColumn& column, size_t rows)
+            {
+                column.Reserve(rows);
+            }
+
+            static size_t size(const Columns::StringColumn& column)
+            {
+                return column.Size();
+            }
+
+            static void truncate(Columns::StringColumn& column, size_t rows)
+            {
+                column.Truncate(rows);
+            }
+
+            static void append(Columns::StringColumn& column, const tinyxml2::XMLElement* e)
+            {
+                column.Append(e->GetText());
+            }
+
+            static void append(Columns::StringColumn& column, const tinyxml2::XMLAttribute* a)
+            {
+                column.Append(a->Value());
+            }
+
+            static void append_default(Columns::StringColumn& column, const std::string& value)
+            {
+                column.Append(value);
+            }
+        };
+    }
+
+    // column bound to named child element, for use with Element::ConvertColumns
+    template<typename TColumn>
+    Columns::ChildColumn<TColumn> ChildColumn(Key name, TColumn& out)
+    {
+        return Columns::ChildColumn<TColumn>(name, out);
+    }
+
+    // column bound to optional named child element, for use with Element::ConvertColumns
+    template<typename TColumn, typename TValue>
+    Columns::ChildColumnOptional<TColumn, typename std::decay<const TValue>::type> ChildColumnOptional(Key name, TColumn& out, const TValue& defaultVal)
+    {
+        return Columns::ChildColumnOptional<TColumn, typename std::decay<const TValue>::type>(name, out, defaultVal);
+    }
+
+    // column bound to named attribute, for use with Element::ConvertColumns
+    template<typename TColumn>
+    Columns::AttributeColumn<TColumn> AttributeColumn(Key name, TColumn& out)
+    {
+        return Columns::AttributeColumn<TColumn>(name, out);
+    }
+
+    // column bound to optional named attribute, for use with Element::ConvertColumns
+    template<typename TColumn, typename TValue>
+    Columns::AttributeColumnOptional<TColumn, typename std::decay<const TValue>::type> AttributeColumnOptional(Key name, TColumn& out, const TValue& defaultVal)
+    {
+        return Columns::AttributeColumnOptional<TColumn, typename std::decay<const TValue>::type>(name, out, defaultVal);
+    }
+
+    namespace Bindings
+    {
+        // bindings refer to the name they were created with without copying it, they are
+        // meant to be created in the call to Element::ConvertAttributes and not kept.
+        template<typename T>
+        class AttributeBinding
+        {
+        public:
+            AttributeBinding(Key name, T& out)
+                : _name(name), _out(out)
+            {
+            }
+
+            Key Name() const
+            {
+                return _name;
+            }
+
+            void Convert(const tinyxml2::XMLAttribute* a)
+            {
+                XmlTree::Attribute(a).Convert(_out);
+            }
+
+            // required, nothing to apply
+            bool Default()
+            {
+                return false;
+            }
+
+        private:
+            Key _name;
+            T& _out;
+        };
+
+        template<typename T, typename TValue>
+        class AttributeBindingOptional
+        {
+        public:
+            AttributeBindingOptional(Key name, T& out, const TValue& defaultVal)
+                : _name(name), _out(out), _default(defaultVal)
+            {
+            }
+
+            Key Name() const
+            {
+                return _name;
+            }
+
+            void Convert(const tinyxml2::XMLAttribute* a)
+            {
+                XmlTree::Attribute(a).Convert(_out);
+            }
+
+            bool Default()
+            {
+                _out = _default;
+                return true;
+            }
+
+        private:
+            Key _name;
+            T& _out;
+            TValue _default;
+        };
+
+        template<typename T>
+        class AttributeBindingOptional<Optional<T>, void>
+        {
+        public:
+            AttributeBindingOptional(Key name, Optional<T>& out)
+                : _name(name), _out(out)
+            {
+            }
+
+            Key Name() const
+            {
+                return _name;
+            }
+
+            void Convert(const tinyxml2::XMLAttribute* a)
+            {
+                _out.HasValue(true);
+                XmlTree::Attribute(a).Convert(_out.Value());
+            }
+
+            bool Default()
+            {
+                _out.Reset();
+                return true;
+            }
+
+        private:
+            Key _name;
+            Optional<T>& _out;
+        };
+    }
+
+    // required attribute, for use with Element::ConvertAttributes
+    template<typename T>
+    Bindings::AttributeBinding<T> AttributeBinding(Key name, T& out)
+    {
+        return Bindings::AttributeBinding<T>(name, out);
+    }
+
+    // optional attribute, for use with Element::ConvertAttributes
+    template<typename T, typename TValue>
+    Bindings::AttributeBindingOptional<T, typename std::decay<const TValue>::type> AttributeBindingOptional(Key name, T& out, const TValue& defaultVal)
+    {
+        return Bindings::AttributeBindingOptional<T, typename std::decay<const TValue>::type>(name, out, defaultVal);
+    }
+
+    // optional attribute, for use with Element::ConvertAttributes
+    template<typename T>
+    Bindings::AttributeBindingOptional<Optional<T>, void> AttributeBindingOptional(Key name, Optional<T>& out)
+    {
+        return Bindings::AttributeBindingOptional<Optional<T>, void>(name, out);
+    }
+
+
+
+
+    namespace Enums
+    {
+        template<typename TDerived, typename TEnum>
+        struct EnumStringBase
+        {
+        public:
+            static const std::string& Str(TEnum e)
+            {
+                auto& map = Map();
+
+                auto itr = std::find_if(map.begin(), map.end(), 
+                    [&](const std::pair<TEnum, std::string>& pair)
+                    {
+                        return pair.first == e;
+                    });
+
+                if (itr != map.end())
+                {
+                    return itr->second;
+                }
+
+                throw std::runtime_error("'" + std::to_string(static_cast<int>(e)) + "' is not a valid value for enum and cannot be converted to string.");
+            }
+
+            static TEnum Val(const std::string& str)
+            {
+                auto& map = Map();
+
+                auto itr = std::find_if(map.begin(), map.end(),
+                    [&](const std::pair<TEnum, std::string>& pair)
+                    {
+                        return pair.second == str;
+                    });
+
+                if (itr != map.end())
+                {
+                    return itr->first;
+                }
+
+                throw std::runtime_error("'" + str + "' cannot be converted to a valid enum value.");
+            }
+            
+        protected:
+            using EnumMap = std::vector<std::pair<TEnum, std::string>>;
+
+            // built on first use, initialization of function local statics is thread safe
+            // so concurrent conversions may race to the first lookup.
+            static const EnumMap& Map()
+            {
+                static const EnumMap map = Build();
+                return map;
+            }
+
+            static void Register(TEnum e, const std::string str)
+            {
+                Building()->push_back(std::pair<TEnum, std::string>(e, str));
+            }
+
+        private:
+            static EnumMap Build()
+            {
+                EnumMap map;
+
+                Building() = &map;
+                TDerived::RegisterAll();
+                Building() = nullptr;
+
+                return map;
+            }
+
+            // map under construction, only used while Map() is being initialized
+            static EnumMap*& Building()
+            {
+                static EnumMap* map = nullptr;
+                return map;
+            }
+        };
+
+        template<typename TEnum>
+        struct EnumString : public EnumStringBase<EnumString<TEnum>, TEnum>
+        {
+            static void RegisterAll() { /* static_assert(false, "Enum type not registered with XmlTree."); */ }
+        };
+    }
+
+    namespace detail
+    {
+        // result of parsing text to a value, full when a fixed size target has no room left
+        enum class number_status { ok, invalid, range, full };
+
+        template<typename T>
+        struct is_text_value : std::integral_constant<bool,
+            std::is_same<T, std::string>::value || std::is_same<T, bool>::value ||
+            std::is_same<T, float>::value || std::is_same<T, double>::value ||
+            std::is_same<T, uint16_t>::value || std::is_same<T, int16_t>::value ||
+            std::is_same<T, uint32_t>::value || std::is_same<T, int32_t>::value ||
+            std::is_same<T, uint64_t>::value || std::is_same<T, int64_t>::value>
+        {
+        };
+
+        // text of element or attribute to built-in value type. Numbers are parsed like
+        // std::stol, std::stod... and cast to the target type, bool is true if the text
+        // starts with "true" after leading whitespace.
+        XMLTREE_INLINE number_status parse_text(const char* text, std::string& out);
+        XMLTREE_INLINE number_status parse_text(const char* text, bool& out);
+        XMLTREE_INLINE number_status parse_text(const char* text, float& out);
+        XMLTREE_INLINE number_status parse_text(const char* text, double& out);
+        XMLTREE_INLINE number_status parse_text(const char* text, uint16_t& out);
+        XMLTREE_INLINE number_status parse_text(const char* text, int16_t& out);
+        XMLTREE_INLINE number_status parse_text(const char* text, uint32_t& out);
+        XMLTREE_INLINE number_status parse_text(const char* text, int32_t& out);
+        XMLTREE_INLINE number_status parse_text(const char* text, uint64_t& out);
+        XMLTREE_INLINE number_status parse_text(const char* text, int64_t& out);
+
+        XMLTREE_INLINE void throw_text_error(number_status status, const char* text, const char* kind, const std::string& name);
+
+        // kind of source for error messages
+        inline const char* source_kind(const Element&)
+        {
+            return "element";
         }
 
-        template<>
-        inline void Convert<uint64_t>(Element& a, uint64_t& out)
+        inline const char* source_kind(const Attribute&)
         {
-            out = std::stoull(a.Value());
+            return "attribute";
         }
 
-        template<>
-        inline void Convert<int64_t>(Element& a, int64_t& out)
+        // TSource is Element or Attribute
+        template<typename TSource, typename T>
+        void convert_text(TSource& source, T& out)
         {
-            out = std::stoll(a.Value());
+            const char* text = source.RawValue();
+            const number_status status = parse_text(text, out);
+            if (status != number_status::ok)
+            {
+                throw_text_error(status, text, source_kind(source), source.Name());
+            }
         }
 
+#if !defined(XMLTREE_COMPILED) || defined(XMLTREE_IMPLEMENTATION)
+        // strto* function result checked like std::sto* does
+        template<typename T, typename TResult, typename... TArgs>
+        number_status parse_c(const char* text, T& out, TResult (*parse)(const char*, char**, TArgs...), TArgs... args)
+        {
+            char* end;
+            errno = 0;
+            const TResult value = parse(text, &end, args...);
+            if (end == text)
+            {
+                return number_status::invalid;
+            }
 
-        // attributes
+            if (errno == ERANGE)
+            {
+                return number_status::range;
+            }
 
-        template<>
-        inline void Convert<std::string>(Attribute& a, std::string& out)
+            out = static_cast<T>(value);
+            return number_status::ok;
+        }
+
+        XMLTREE_INLINE void throw_text_error(number_status status, const char* text, const char* kind, const std::string& name)
         {
-            out = a.Value();
+            throw std::runtime_error("'" + std::string(text) + "' in " + kind + " '" + name + "' " +
+                (status == number_status::range ? "is out of range." : "is not a valid number."));
         }
 
-        template<>
-        inline void Convert<bool>(Attribute& a, bool& out)
+        XMLTREE_INLINE number_status parse_text(const char* text, std::string& out)
         {
-            out = false;
-            std::istringstream(a.Value()) >> std::boolalpha >> out;
+            out.assign(text);
+            return number_status::ok;
         }
 
-        template<>
-        inline void Convert<float>(Attribute& a, float& out)
+        XMLTREE_INLINE number_status parse_text(const char* text, bool& out)
         {
-            out = std::stof(a.Value());
+            while (is_space(*text))
+            {
+                ++text;
+            }
+
+            out = std::strncmp(text, "true", 4) == 0;
+            return number_status::ok;
         }
 
-        template<>
-        inline void Convert<double>(Attribute& a, double& out)
+        XMLTREE_INLINE number_status parse_text(const char* text, float& out)
         {
-            out = std::stod(a.Value());
+            return parse_c(text, out, &std::strtof);
         }
 
-        template<>
-        inline void Convert<uint16_t>(Attribute& a, uint16_t& out)
+        XMLTREE_INLINE number_status parse_text(const char* text, double& out)
         {
-            out = static_cast<uint16_t>(std::stoul(a.Value()));
+            return parse_c(text, out, &std::strtod);
         }
 
-        template<>
-        inline void Convert<int16_t>(Attribute& a, int16_t& out)
+        XMLTREE_INLINE number_status parse_text(const char* text, uint16_t& out)
         {
-            out = static_cast<int16_t>(std::stol(a.Value()));
+            return parse_c(text, out, &std::strtoul, 10);
         }
 
-        template<>
-        inline void Convert<uint32_t>(Attribute& a, uint32_t& out)
+        XMLTREE_INLINE number_status parse_text(const char* text, int16_t& out)
         {
-            out = std::stoul(a.Value());
+            return parse_c(text, out, &std::strtol, 10);
         }
 
-        template<>
-        inline void Convert<int32_t>(Attribute& a, int32_t& out)
+        XMLTREE_INLINE number_status parse_text(const char* text, uint32_t& out)
         {
-            out = std::stol(a.Value());
+            return parse_c(text, out, &std::strtoul, 10);
         }
 
-        template<>
-        inline void Convert<uint64_t>(Attribute& a, uint64_t& out)
+        XMLTREE_INLINE number_status parse_text(const char* text, int32_t& out)
         {
-            out = std::stoull(a.Value());
+            return parse_c(text, out, &std::strtol, 10);
         }
 
-        template<>
-        inline void Convert<int64_t>(Attribute& a, int64_t& out)
+        XMLTREE_INLINE number_status parse_text(const char* text, uint64_t& out)
+        {
+            return parse_c(text, out, &std::strtoull, 10);
+        }
+
+        XMLTREE_INLINE number_status parse_text(const char* text, int64_t& out)
+        {
+            return parse_c(text, out, &std::strtoll, 10);
+        }
+#endif
+    }
+
+    namespace Converters
+    {
+        // types without a Convert specialization are handed to Converter
+
+        template<typename T>
+        void Convert(Element& e, T& out)
+        {
+            Converter<T>::Convert(e, out);
+        }
+
+        template<typename T>
+        void Convert(Attribute& a, T& out)
+        {
+            Converter<T>::Convert(a, out);
+        }
+
+        // built-in value types, parsed from the raw text of element or attribute
+        template<typename T>
+        struct Converter<T, typename std::enable_if<detail::is_text_value<T>::value>::type>
+        {
+            // TSource is Element or Attribute
+            template<typename TSource>
+            static void Convert(TSource& source, T& out);
+        };
+
+        template<typename T>
+        template<typename TSource>
+        void Converter<T, typename std::enable_if<detail::is_text_value<T>::value>::type>::Convert(TSource& source, T& out)
+        {
+            detail::convert_text(source, out);
+        }
+    }
+
+    // with XMLTREE_COMPILED the conversion chain of each built-in value type is instantiated
+    // once in src/XmlTree.cpp and declared extern template everywhere else
+#if defined(XMLTREE_COMPILED) && !defined(XMLTREE_IMPLEMENTATION)
+    XMLTREE_FOR_EACH_VALUE_TYPE(XMLTREE_EXTERN_VALUE_CONVERTER)
+#endif
+
+    enum class Whitespace
+    {
+        // keep all whitespace in text
+        Preserve,
+
+        // trim text and collapse runs of whitespace into a single space
+        Collapse,
+
+        // keep whitespace only text nodes too, requires tinyxml2 10 or later
+        Pedantic
+    };
+
+    // document parse options for Read, Parse, SharedDocument and the streaming readers
+    struct Options
+    {
+        // translate entities such as &amp; and &#60; in text and attribute values. Input known
+        // to be free of entities parses faster without, text is then returned exactly as written.
+        bool processEntities = true;
+
+        Whitespace whitespace = Whitespace::Preserve;
+    };
+
+    namespace detail
+    {
+        inline tinyxml2::Whitespace document_whitespace(Whitespace whitespace)
         {
-            out = std::stoll(a.Value());
+            switch (whitespace)
+            {
+            case Whitespace::Collapse:
+                return tinyxml2::COLLAPSE_WHITESPACE;
+            case Whitespace::Pedantic:
+#if TINYXML2_MAJOR_VERSION >= 10
+                return tinyxml2::PEDANTIC_WHITESPACE;
+#else
+                throw std::runtime_error("Pedantic whitespace requires tinyxml2 10 or later.");
+#endif
+            default:
+                return tinyxml2::PRESERVE_WHITESPACE;
+            }
         }
     }
 
+    // Parsed document that can be shared between threads. The document is immutable once
+    // created and all text in it is resolved up front, so any number of threads may get
+    // elements from it and convert them concurrently. Copies share the same document,
+    // elements stay valid as long as any copy is alive.
+    class SharedDocument
+    {
+    public:
+        // load and parse xml file
+        static SharedDocument Read(const std::string& filePath, const Options& options = Options())
+        {
+            auto doc = std::make_shared<tinyxml2::XMLDocument>(options.processEntities, detail::document_whitespace(options.whitespace));
+            if (tinyxml2::XML_SUCCESS != doc->LoadFile(filePath.c_str()))
+            {
+                throw std::runtime_error(doc->ErrorStr());
+            }
+
+            return SharedDocument(doc);
+        }
+
+        // parse xml string
+        static SharedDocument Parse(const std::string& xml, const Options& options = Options())
+        {
+            auto doc = std::make_shared<tinyxml2::XMLDocument>(options.processEntities, detail::document_whitespace(options.whitespace));
+            if (tinyxml2::XML_SUCCESS != doc->Parse(xml.c_str()))
+            {
+                throw std::runtime_error(doc->ErrorStr());
+            }
+
+            return SharedDocument(doc);
+        }
+
+        // get named root element, throws exception if does not exist.
+        Element Root(const std::string& rootElement) const
+        {
+            auto root = _doc->FirstChildElement(rootElement.c_str());
+            if (root == nullptr)
+            {
+                throw std::runtime_error("Root element '" + rootElement + "' not found.");
+            }
+
+            return Element(root);
+        }
+
+        // convert named root element to type
+        template<typename T>
+        T Convert(const std::string& rootElement) const
+        {
+            T res;
+            Root(rootElement).Convert(res);
+            return res;
+        }
+
+    private:
+        explicit SharedDocument(const std::shared_ptr<tinyxml2::XMLDocument>& doc)
+            : _doc(doc)
+        {
+            Resolve(*doc);
+        }
+
+        // tinyxml2 unescapes names and text lazily on first access, writing the result back
+        // into the document. Touch every string once so later accesses are read only.
+        static void Resolve(const tinyxml2::XMLDocument& doc)
+        {
+            const tinyxml2::XMLNode* node = doc.FirstChild();
+            while (node != nullptr)
+            {
+                node->Value();
+                if (auto e = node->ToElement())
+                {
+                    for (auto a = e->FirstAttribute(); a != nullptr; a = a->Next())
+                    {
+                        a->Name();
+                        a->Value();
+                    }
+                }
+
+                if (node->FirstChild() != nullptr)
+                {
+                    node = node->FirstChild();
+                    continue;
+                }
+
+                while (node != nullptr && node->NextSibling() == nullptr)
+                {
+                    node = node->Parent();
+                }
+
+                if (node != nullptr)
+                {
+                    node = node->NextSibling();
+                }
+            }
+        }
+
+        std::shared_ptr<const tinyxml2::XMLDocument> _doc;
+    };
+
     template<typename T>
-    T Read(const std::string& filePath, const std::string& rootElement)
+    T Read(const std::string& filePath, const std::string& rootElement, const Options& options = Options())
     {
         T res;
 
-        tinyxml2::XMLDocument doc;
+        tinyxml2::XMLDocument doc(options.processEntities, detail::document_whitespace(options.whitespace));
         if (tinyxml2::XML_SUCCESS != doc.LoadFile(filePath.c_str()))
         {
             throw std::runtime_error(doc.ErrorStr());
@@ -634,11 +1931,11 @@ namespace XmlTree
     }
 
     template<typename T>
-    T Parse(const std::string& xml, const std::string& rootElement)
+    T Parse(const std::string& xml, const std::string& rootElement, const Options& options = Options())
     {
         T res;
 
-        tinyxml2::XMLDocument doc;
+        tinyxml2::XMLDocument doc(options.processEntities, detail::document_whitespace(options.whitespace));
         if (tinyxml2::XML_SUCCESS != doc.Parse(xml.c_str()))
         {
             throw std::runtime_error(doc.ErrorStr());
@@ -0,0 +1,478 @@
+/*
+ * XmlTreeArrays.h
+ *
+ * Copyright (C) 2017 Daniel Nilsson
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#pragma once
+#include "XmlTree.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+// Vectorized delimiter scanning is selected at compile time from the target instruction set,
+// define XMLTREE_NO_SIMD to force the scalar implementation.
+#if !defined(XMLTREE_NO_SIMD) && defined(__AVX2__)
+#define XMLTREE_ARRAYS_AVX2
+#endif
+
+#if !defined(XMLTREE_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define XMLTREE_ARRAYS_SSE2
+#endif
+
+#if defined(XMLTREE_ARRAYS_SSE2) || defined(XMLTREE_ARRAYS_AVX2)
+#include <immintrin.h>
+#endif
+
+namespace XmlTree
+{
+    namespace detail
+    {
+        template<typename T>
+        struct is_array_value : std::integral_constant<bool,
+            std::is_same<T, float>::value || std::is_same<T, double>::value ||
+            std::is_same<T, int32_t>::value || std::is_same<T, int64_t>::value>
+        {
+        };
+
+        struct number_error
+        {
+            number_status status;
+
+            // index of offending value and its text
+            size_t index;
+            const char* begin;
+            const char* end;
+        };
+
+        inline unsigned popcount32(uint32_t v)
+        {
+            v = v - ((v >> 1) & 0x55555555);
+            v = (v & 0x33333333) + ((v >> 2) & 0x33333333);
+            return (((v + (v >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+        }
+
+        // number of whitespace separated tokens in [p, end). A token starts at every
+        // non space byte preceded by a space byte, found for a whole block at a time
+        // from the whitespace mask of the block shifted by one.
+        inline size_t count_tokens(const char* p, const char* end)
+        {
+            size_t count = 0;
+            uint32_t space = 1;
+
+#ifdef XMLTREE_ARRAYS_AVX2
+            {
+                const __m256i sp = _mm256_set1_epi8(' ');
+                const __m256i tab = _mm256_set1_epi8('\t');
+                const __m256i lf = _mm256_set1_epi8('\n');
+                const __m256i cr = _mm256_set1_epi8('\r');
+
+                while (end - p >= 32)
+                {
+                    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+                    const __m256i ws = _mm256_or_si256(
+                        _mm256_or_si256(_mm256_cmpeq_epi8(v, sp), _mm256_cmpeq_epi8(v, tab)),
+                        _mm256_or_si256(_mm256_cmpeq_epi8(v, lf), _mm256_cmpeq_epi8(v, cr)));
+
+                    const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(ws));
+                    count += popcount32(~mask & ((mask << 1) | space));
+                    space = mask >> 31;
+                    p += 32;
+                }
+            }
+#endif
+
+#ifdef XMLTREE_ARRAYS_SSE2
+            {
+                const __m128i sp = _mm_set1_epi8(' ');
+                const __m128i tab = _mm_set1_epi8('\t');
+                const __m128i lf = _mm_set1_epi8('\n');
+                const __m128i cr = _mm_set1_epi8('\r');
+
+                while (end - p >= 16)
+                {
+                    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                    const __m128i ws = _mm_or_si128(
+                        _mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, tab)),
+                        _mm_or_si128(_mm_cmpeq_epi8(v, lf), _mm_cmpeq_epi8(v, cr)));
+
+                    const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(ws));
+                    count += popcount32(~mask & ((mask << 1) | space) & 0xFFFF);
+                    space = (mask >> 15) & 1;
+                    p += 16;
+                }
+            }
+#endif
+
+            for (; p != end; ++p)
+            {
+                const uint32_t s = is_space(*p) ? 1 : 0;
+                count += ~s & space & 1;
+                space = s;
+            }
+
+            return count;
+        }
+
+        template<typename T>
+        number_status parse_integer(const char*& p, T& out)
+        {
+            typedef typename std::make_unsigned<T>::type U;
+
+            const bool negative = *p == '-';
+            if (negative || *p == '+')
+            {
+                ++p;
+            }
+
+            const U limit = static_cast<U>(std::numeric_limits<T>::max()) + (negative ? 1 : 0);
+            const char* begin = p;
+
+            U v = 0;
+            bool range = false;
+            for (unsigned d; (d = static_cast<unsigned>(*p - '0')) <= 9; ++p)
+            {
+                if (v > (limit - d) / 10)
+                {
+                    range = true;
+                }
+                else
+                {
+                    v = v * 10 + d;
+                }
+            }
+
+            if (p == begin)
+            {
+                return number_status::invalid;
+            }
+
+            if (range)
+            {
+                return number_status::range;
+            }
+
+            out = negative && v != 0 ? -static_cast<T>(v - 1) - 1 : static_cast<T>(v);
+            return number_status::ok;
+        }
+
+        template<typename T> struct float_traits;
+
+        template<>
+        struct float_traits<float>
+        {
+            static const uint64_t max_mantissa = uint64_t(1) << 24;
+            static const int max_exponent = 10;
+
+            static float pow10(int e)
+            {
+                static const float table[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+                return table[e];
+            }
+
+            static float parse(const char* p, char** end)
+            {
+                return std::strtof(p, end);
+            }
+        };
+
+        template<>
+        struct float_traits<double>
+        {
+            static const uint64_t max_mantissa = uint64_t(1) << 53;
+            static const int max_exponent = 22;
+
+            static double pow10(int e)
+            {
+                static const double table[] =
+                {
+                    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+                };
+
+                return table[e];
+            }
+
+            static double parse(const char* p, char** end)
+            {
+                return std::strtod(p, end);
+            }
+        };
+
+        // Decimal numbers whose digits and power of ten are both exactly representable are
+        // computed with a single correctly rounded multiply or divide. Anything else, such as
+        // long mantissas, large exponents, inf and nan, falls back to strtod/strtof.
+        template<typename T>
+        number_status parse_float(const char*& p, T& out)
+        {
+            typedef float_traits<T> traits;
+
+            const char* q = p;
+            const bool negative = *q == '-';
+            if (negative || *q == '+')
+            {
+                ++q;
+            }
+
+            uint64_t mantissa = 0;
+            int exponent = 0;
+            bool exact = true;
+            bool digits = false;
+
+            for (unsigned d; (d = static_cast<unsigned>(*q - '0')) <= 9; ++q)
+            {
+                digits = true;
+                exact = exact && mantissa <= (traits::max_mantissa - d) / 10;
+                mantissa = mantissa * 10 + d;
+            }
+
+            if (*q == '.')
+            {
+                ++q;
+                for (unsigned d; (d = static_cast<unsigned>(*q - '0')) <= 9; ++q)
+                {
+                    digits = true;
+                    exact = exact && mantissa <= (traits::max_mantissa - d) / 10;
+                    mantissa = mantissa * 10 + d;
+                    --exponent;
+                }
+            }
+
+            if (digits && (*q == 'e' || *q == 'E'))
+            {
+                ++q;
+                const bool negativeExponent = *q == '-';
+                if (negativeExponent || *q == '+')
+                {
+                    ++q;
+                }
+
+                int e = 0;
+                bool any = false;
+                for (unsigned d; (d = static_cast<unsigned>(*q - '0')) <= 9; ++q)
+                {
+                    any = true;
+                    e = e < 10000 ? e * 10 + static_cast<int>(d) : e;
+                }
+
+                exact = exact && any;
+                exponent += negativeExponent ? -e : e;
+            }
+
+            if (digits && exact && exponent >= -traits::max_exponent && exponent <= traits::max_exponent)
+            {
+                T v = static_cast<T>(mantissa);
+                v = exponent < 0 ? v / traits::pow10(-exponent) : v * traits::pow10(exponent);
+                out = negative ? -v : v;
+                p = q;
+                return number_status::ok;
+            }
+
+            char* stop;
+            errno = 0;
+            const T v = traits::parse(p, &stop);
+            if (stop == p)
+            {
+                return number_status::invalid;
+            }
+
+            p = stop;
+            if (errno == ERANGE && std::isinf(v))
+            {
+                return number_status::range;
+            }
+
+            out = v;
+            return number_status::ok;
+        }
+
+        inline number_status parse_number(const char*& p, int32_t& out)
+        {
+            return parse_integer(p, out);
+        }
+
+        inline number_status parse_number(const char*& p, int64_t& out)
+        {
+            return parse_integer(p, out);
+        }
+
+        inline number_status parse_number(const char*& p, float& out)
+        {
+            return parse_float(p, out);
+        }
+
+        inline number_status parse_number(const char*& p, double& out)
+        {
+            return parse_float(p, out);
+        }
+
+        // parse whitespace separated values of null terminated text into out, stops with
+        // status full when text has more than capacity values.
+        template<typename T>
+        number_error parse_numbers(const char* p, T* out, size_t capacity, size_t& count)
+        {
+            count = 0;
+            for (;;)
+            {
+                while (is_space(*p))
+                {
+                    ++p;
+                }
+
+                if (*p == '\0')
+                {
+                    return number_error{ number_status::ok, count, p, p };
+                }
+
+                const char* begin = p;
+                number_status status = number_status::full;
+                if (count < capacity)
+                {
+                    status = parse_number(p, out[count]);
+                    if (status == number_status::ok && *p != '\0' && !is_space(*p))
+                    {
+                        status = number_status::invalid;
+                    }
+                }
+
+                if (status != number_status::ok)
+                {
+                    const char* end = begin;
+                    while (*end != '\0' && !is_space(*end))
+                    {
+                        ++end;
+                    }
+
+                    return number_error{ status, count, begin, end };
+                }
+
+                ++count;
+            }
+        }
+
+        template<typename TSource>
+        void throw_number_error(const TSource& source, const char* kind, const number_error& err, size_t capacity)
+        {
+            const std::string value(err.begin, err.end);
+            const std::string where = " at index " + std::to_string(err.index) + " in " + kind + " '" + source.Name() + "'";
+
+            switch (err.status)
+            {
+            case number_status::range:
+                throw std::runtime_error("Value '" + value + "'" + where + " is out of range.");
+            case number_status::full:
+                throw std::runtime_error("Too many values in " + std::string(kind) + " '" + source.Name() +
+                    "', buffer holds " + std::to_string(capacity) + ".");
+            default:
+                throw std::runtime_error("Invalid value '" + value + "'" + where + ".");
+            }
+        }
+
+        // vector is reserved from a token count of the text, values are parsed through a
+        // small buffer and appended so the vector is written once instead of first being
+        // zero filled by resize
+        template<typename TSource, typename T, typename TAlloc>
+        void convert_numbers(const TSource& source, const char* kind, std::vector<T, TAlloc>& out)
+        {
+            const char* text = source.RawValue();
+            const size_t tokens = count_tokens(text, text + std::strlen(text));
+            out.clear();
+            out.reserve(tokens);
+
+            T chunk[256];
+            for (;;)
+            {
+                size_t count;
+                number_error err = parse_numbers(text, chunk, sizeof(chunk) / sizeof(chunk[0]), count);
+                out.insert(out.end(), chunk, chunk + count);
+
+                if (err.status == number_status::ok)
+                {
+                    return;
+                }
+
+                if (err.status != number_status::full)
+                {
+                    err.index = out.size();
+                    out.clear();
+                    throw_number_error(source, kind, err, tokens);
+                }
+
+                text = err.begin;
+            }
+        }
+    }
+
+    namespace Arrays
+    {
+        // Caller provided buffer receiving whitespace separated numbers from text,
+        // created by XmlTree::Span.
+        template<typename T>
+        class Span
+        {
+            static_assert(detail::is_array_value<T>::value, "Span supports float, double, int32_t and int64_t.");
+
+        public:
+            Span(T* data, size_t capacity, size_t& count)
+                : _data(data), _capacity(capacity), _count(&count)
+            {
+            }
+
+            // parse raw text of element or attribute
+            template<typename TSource>
+            void Parse(const TSource& source, const char* kind)
+            {
+                const detail::number_error err = detail::parse_numbers(source.RawValue(), _data, _capacity, *_count);
+                if (err.status != detail::number_status::ok)
+                {
+                    *_count = 0;
+                    detail::throw_number_error(source, kind, err, _capacity);
+                }
+            }
+
+        private:
+            T* _data;
+            size_t _capacity;
+            size_t* _count;
+        };
+    }
+
+    // parse whitespace separated numbers into caller provided buffer, count is set to number
+    // of values read, e.g. e.Convert("samples", XmlTree::Span(buffer, 1024, count))
+    template<typename T>
+    Arrays::Span<T> Span(T* data, size_t capacity, size_t& count)
+    {
+        return Arrays::Span<T>(data, capacity, count);
+    }
+
+    namespace Converters
+    {
+        // std::vector of float, double, int32_t or int64_t from whitespace separated text,
+        // e.g. <samples>1.25 3.5 -0.75</samples>. Errors report the index of the bad value.
+        template<typename T, typename TAlloc>
+        struct Converter<std::vector<T, TAlloc>, typename std::enable_if<detail::is_array_value<T>::value>::type>
+        {
+            template<typename TSource>
+            static void Convert(TSource& source, std::vector<T, TAlloc>& out)
+            {
+                detail::convert_numbers(source, detail::source_kind(source), out);
+            }
+        };
+
+        template<typename T>
+        struct Converter<Arrays::Span<T>>
+        {
+            template<typename TSource>
+            static void Convert(TSource& source, Arrays::Span<T>& out)
+            {
+                out.Parse(source, detail::source_kind(source));
+            }
+        };
+    }
+}
\ No newline at end of file
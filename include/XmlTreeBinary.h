@@ -0,0 +1,557 @@
+/*
+ * XmlTreeBinary.h
+ *
+ * Copyright (C) 2017 Daniel Nilsson
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#pragma once
+#include "XmlTree.h"
+
+#include <cstring>
+
+// Vectorized decoding is selected at compile time from the target instruction set,
+// define XMLTREE_NO_SIMD to force the scalar implementation.
+#if !defined(XMLTREE_NO_SIMD) && defined(__AVX2__)
+#define XMLTREE_BINARY_AVX2
+#endif
+
+#if !defined(XMLTREE_NO_SIMD) && (defined(__SSSE3__) || defined(__AVX__) || defined(XMLTREE_BINARY_AVX2))
+#define XMLTREE_BINARY_SSSE3
+#endif
+
+#if defined(XMLTREE_BINARY_SSSE3) || defined(XMLTREE_BINARY_AVX2)
+#include <immintrin.h>
+#endif
+
+namespace XmlTree
+{
+    namespace detail
+    {
+        struct decode_result
+        {
+            bool ok;
+
+            // decoded bytes if ok, otherwise offset of offending character in input
+            size_t length;
+            const char* error;
+
+            // input characters decoded if ok, less than the input length only when resumable
+            size_t consumed;
+        };
+
+        enum : signed char { decode_invalid = -1, decode_space = -2, decode_pad = -3 };
+
+        // output bytes written beyond the decoded data by the vectorized paths
+        static const size_t decode_slack = 32;
+
+        inline const signed char* base64_table()
+        {
+            static const signed char table[256] =
+            {
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -2, -2, -1, -1, -2, -1, -1,
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                -2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, -1, 63,
+                52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -3, -1, -1,
+                -1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+                15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
+                -1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+                41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1,
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+            };
+
+            return table;
+        }
+
+        inline const signed char* hex_table()
+        {
+            static const signed char table[256] =
+            {
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -2, -2, -1, -1, -2, -1, -1,
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                -2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+                -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+            };
+
+            return table;
+        }
+
+#ifdef XMLTREE_BINARY_SSSE3
+        // 16 base64 characters to 12 bytes, writes 16 bytes. Returns false without writing if
+        // the block contains anything but base64 alphabet (whitespace, padding, invalid).
+        inline bool base64_decode_block(const char* in, uint8_t* out)
+        {
+            const __m128i lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+            const __m128i lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+            const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+            const __m128i mask2F = _mm_set1_epi8(0x2F);
+
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+
+            const __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(v, 4), mask2F);
+            const __m128i lo = _mm_shuffle_epi8(lutLo, _mm_and_si128(v, mask2F));
+            const __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0xFFFF)
+            {
+                return false;
+            }
+
+            const __m128i eq2F = _mm_cmpeq_epi8(v, mask2F);
+            const __m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(eq2F, hiNibbles));
+            v = _mm_add_epi8(v, roll);
+
+            // pack 4 x 6 bits into 3 bytes
+            v = _mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140));
+            v = _mm_madd_epi16(v, _mm_set1_epi32(0x00011000));
+            v = _mm_shuffle_epi8(v, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), v);
+            return true;
+        }
+
+        // 32 hex characters to 16 bytes, returns false without writing on anything but hex digits
+        inline bool hex_decode_block(const char* in, uint8_t* out)
+        {
+            auto nibbles = [](__m128i v, bool& ok)
+            {
+                const __m128i digit = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+                const __m128i isDigit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+
+                const __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+                const __m128i alpha = _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10));
+                const __m128i isAlpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+
+                ok = ok && _mm_movemask_epi8(_mm_or_si128(isDigit, isAlpha)) == 0xFFFF;
+
+                // high nibble first: n[2i] * 16 + n[2i + 1]
+                const __m128i n = _mm_or_si128(_mm_and_si128(isDigit, digit), _mm_andnot_si128(isDigit, alpha));
+                return _mm_maddubs_epi16(n, _mm_set1_epi16(0x0110));
+            };
+
+            bool ok = true;
+            const __m128i a = nibbles(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in)), ok);
+            const __m128i b = nibbles(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 16)), ok);
+            if (!ok)
+            {
+                return false;
+            }
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(a, b));
+            return true;
+        }
+#endif
+
+#ifdef XMLTREE_BINARY_AVX2
+        // 32 base64 characters to 24 bytes, writes 32 bytes, see SSSE3 version
+        inline bool base64_decode_block2(const char* in, uint8_t* out)
+        {
+            const __m256i lutLo = _mm256_setr_epi8(
+                0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+                0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+            const __m256i lutHi = _mm256_setr_epi8(
+                0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+                0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+            const __m256i lutRoll = _mm256_setr_epi8(
+                0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+                0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+            const __m256i mask2F = _mm256_set1_epi8(0x2F);
+
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+
+            const __m256i hiNibbles = _mm256_and_si256(_mm256_srli_epi32(v, 4), mask2F);
+            const __m256i lo = _mm256_shuffle_epi8(lutLo, _mm256_and_si256(v, mask2F));
+            const __m256i hi = _mm256_shuffle_epi8(lutHi, hiNibbles);
+
+            if (!_mm256_testz_si256(lo, hi))
+            {
+                return false;
+            }
+
+            const __m256i eq2F = _mm256_cmpeq_epi8(v, mask2F);
+            const __m256i roll = _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(eq2F, hiNibbles));
+            v = _mm256_add_epi8(v, roll);
+
+            v = _mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140));
+            v = _mm256_madd_epi16(v, _mm256_set1_epi32(0x00011000));
+            v = _mm256_shuffle_epi8(v, _mm256_setr_epi8(
+                2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+            v = _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), v);
+            return true;
+        }
+#endif
+
+        // decode base64, whitespace anywhere is skipped and padding is optional.
+        // out must have room for capacity bytes, of which the vectorized paths may use
+        // up to decode_slack bytes beyond the decoded data. If resumable a full out is not
+        // an error, decoding stops before the first group that does not fit and consumed
+        // tells where to continue.
+        inline decode_result base64_decode(const char* in, size_t len, uint8_t* out, size_t capacity, bool resumable = false)
+        {
+            const signed char* table = base64_table();
+
+            size_t i = 0;
+            size_t o = 0;
+            uint32_t quad = 0;
+            int n = 0;
+            int pad = 0;
+
+            // input position of the first character of the current group
+            size_t group = 0;
+
+#if defined(XMLTREE_BINARY_SSSE3)
+            // after a block fails to decode vectorized, decode at least a block worth scalar
+            size_t scalarUntil = 0;
+#endif
+
+            while (i < len)
+            {
+#if defined(XMLTREE_BINARY_SSSE3)
+                if (n == 0 && pad == 0 && i >= scalarUntil)
+                {
+#if defined(XMLTREE_BINARY_AVX2)
+                    while (i + 32 <= len && o + 32 <= capacity && base64_decode_block2(in + i, out + o))
+                    {
+                        i += 32;
+                        o += 24;
+                    }
+#endif
+                    while (i + 16 <= len && o + 16 <= capacity && base64_decode_block(in + i, out + o))
+                    {
+                        i += 16;
+                        o += 12;
+                    }
+
+                    scalarUntil = i + 16;
+                    if (i == len)
+                    {
+                        break;
+                    }
+                }
+#endif
+                const signed char v = table[static_cast<unsigned char>(in[i])];
+                if (v >= 0)
+                {
+                    if (pad > 0)
+                    {
+                        return decode_result{ false, i, "data after padding", 0 };
+                    }
+
+                    if (n == 0)
+                    {
+                        group = i;
+                    }
+
+                    quad = (quad << 6) | static_cast<uint32_t>(v);
+                    if (++n == 4)
+                    {
+                        if (o + 3 > capacity)
+                        {
+                            if (resumable)
+                            {
+                                return decode_result{ true, o, nullptr, group };
+                            }
+
+                            return decode_result{ false, i, "decoded data does not fit in buffer", 0 };
+                        }
+
+                        out[o++] = static_cast<uint8_t>(quad >> 16);
+                        out[o++] = static_cast<uint8_t>(quad >> 8);
+                        out[o++] = static_cast<uint8_t>(quad);
+                        quad = 0;
+                        n = 0;
+                    }
+                }
+                else if (v == decode_pad)
+                {
+                    // "xx==" or "xxx=", nothing but whitespace may follow
+                    if (n + pad < 2 || n + pad >= 4)
+                    {
+                        return decode_result{ false, i, "unexpected padding", 0 };
+                    }
+
+                    ++pad;
+                }
+                else if (v != decode_space)
+                {
+                    return decode_result{ false, i, "invalid character", 0 };
+                }
+
+                ++i;
+            }
+
+            if (n == 1 || (pad > 0 && n + pad != 4))
+            {
+                return decode_result{ false, len, "truncated data", 0 };
+            }
+
+            // trailing 2 or 3 characters, padded or not
+            if (n > 1)
+            {
+                if (o + static_cast<size_t>(n - 1) > capacity)
+                {
+                    if (resumable)
+                    {
+                        return decode_result{ true, o, nullptr, group };
+                    }
+
+                    return decode_result{ false, len, "decoded data does not fit in buffer", 0 };
+                }
+
+                quad <<= 6 * (4 - n);
+                out[o++] = static_cast<uint8_t>(quad >> 16);
+                if (n == 3)
+                {
+                    out[o++] = static_cast<uint8_t>(quad >> 8);
+                }
+            }
+
+            return decode_result{ true, o, nullptr, len };
+        }
+
+        // decode hex, upper or lower case, whitespace anywhere is skipped.
+        // Capacity and resumable as for base64_decode.
+        inline decode_result hex_decode(const char* in, size_t len, uint8_t* out, size_t capacity, bool resumable = false)
+        {
+            const signed char* table = hex_table();
+
+            size_t i = 0;
+            size_t o = 0;
+            int high = -1;
+            size_t group = 0;
+
+#if defined(XMLTREE_BINARY_SSSE3)
+            size_t scalarUntil = 0;
+#endif
+
+            while (i < len)
+            {
+#if defined(XMLTREE_BINARY_SSSE3)
+                if (high < 0 && i >= scalarUntil)
+                {
+                    while (i + 32 <= len && o + 16 <= capacity && hex_decode_block(in + i, out + o))
+                    {
+                        i += 32;
+                        o += 16;
+                    }
+
+                    scalarUntil = i + 32;
+                    if (i == len)
+                    {
+                        break;
+                    }
+                }
+#endif
+                const signed char v = table[static_cast<unsigned char>(in[i])];
+                if (v >= 0)
+                {
+                    if (high < 0)
+                    {
+                        high = v;
+                        group = i;
+                    }
+                    else
+                    {
+                        if (o >= capacity)
+                        {
+                            if (resumable)
+                            {
+                                return decode_result{ true, o, nullptr, group };
+                            }
+
+                            return decode_result{ false, i, "decoded data does not fit in buffer", 0 };
+                        }
+
+                        out[o++] = static_cast<uint8_t>((high << 4) | v);
+                        high = -1;
+                    }
+                }
+                else if (v != decode_space)
+                {
+                    return decode_result{ false, i, "invalid character", 0 };
+                }
+
+                ++i;
+            }
+
+            if (high >= 0)
+            {
+                return decode_result{ false, len, "odd number of digits", 0 };
+            }
+
+            return decode_result{ true, o, nullptr, len };
+        }
+    }
+
+    namespace Binary
+    {
+        struct Base64Encoding
+        {
+            static size_t MaxSize(size_t textLength)
+            {
+                return textLength / 4 * 3 + 2;
+            }
+
+            static detail::decode_result Decode(const char* in, size_t len, uint8_t* out, size_t capacity, bool resumable)
+            {
+                return detail::base64_decode(in, len, out, capacity, resumable);
+            }
+
+            static const char* Name()
+            {
+                return "base64";
+            }
+        };
+
+        struct HexEncoding
+        {
+            static size_t MaxSize(size_t textLength)
+            {
+                return textLength / 2;
+            }
+
+            static detail::decode_result Decode(const char* in, size_t len, uint8_t* out, size_t capacity, bool resumable)
+            {
+                return detail::hex_decode(in, len, out, capacity, resumable);
+            }
+
+            static const char* Name()
+            {
+                return "hex";
+            }
+        };
+
+        // Destination of binary data decoded from text, either a vector that is sized
+        // to fit or a caller provided buffer. Created by XmlTree::Base64 and XmlTree::Hex.
+        template<typename TEncoding>
+        class Bytes
+        {
+        public:
+            explicit Bytes(std::vector<uint8_t>& out)
+                : _vector(&out), _data(nullptr), _capacity(0), _length(nullptr)
+            {
+            }
+
+            Bytes(uint8_t* data, size_t capacity, size_t& length)
+                : _vector(nullptr), _data(data), _capacity(capacity), _length(&length)
+            {
+            }
+
+            // decode raw text of element or attribute
+            template<typename TSource>
+            void Decode(const TSource& source, const char* kind)
+            {
+                const char* text = source.RawValue();
+                const size_t len = std::strlen(text);
+
+                detail::decode_result res;
+                if (_vector != nullptr)
+                {
+                    // decode through a small buffer and append it, the vector is written once
+                    // instead of first being zero filled by resize
+                    uint8_t chunk[8 * 1024 + detail::decode_slack];
+                    _vector->clear();
+                    _vector->reserve(TEncoding::MaxSize(len));
+
+                    for (size_t begin = 0;;)
+                    {
+                        res = TEncoding::Decode(text + begin, len - begin, chunk, sizeof(chunk), true);
+                        if (!res.ok)
+                        {
+                            res.length += begin;
+                            _vector->clear();
+                            break;
+                        }
+
+                        _vector->insert(_vector->end(), chunk, chunk + res.length);
+                        begin += res.consumed;
+                        if (begin == len)
+                        {
+                            break;
+                        }
+                    }
+                }
+                else
+                {
+                    res = TEncoding::Decode(text, len, _data, _capacity, false);
+                    *_length = res.ok ? res.length : 0;
+                }
+
+                if (!res.ok)
+                {
+                    throw std::runtime_error("Invalid " + std::string(TEncoding::Name()) + " data in " + kind + " '" + source.Name() +
+                        "' at offset " + std::to_string(res.length) + ": " + res.error + ".");
+                }
+            }
+
+        private:
+            std::vector<uint8_t>* _vector;
+            uint8_t* _data;
+            size_t _capacity;
+            size_t* _length;
+        };
+    }
+
+    // decode base64 text into vector, e.g. e.Convert("attachment", XmlTree::Base64(bytes))
+    inline Binary::Bytes<Binary::Base64Encoding> Base64(std::vector<uint8_t>& out)
+    {
+        return Binary::Bytes<Binary::Base64Encoding>(out);
+    }
+
+    // decode base64 text into caller provided buffer, length is set to number of bytes decoded.
+    // Vectorized decoding is only used while at least 32 bytes of the buffer remain.
+    inline Binary::Bytes<Binary::Base64Encoding> Base64(uint8_t* data, size_t capacity, size_t& length)
+    {
+        return Binary::Bytes<Binary::Base64Encoding>(data, capacity, length);
+    }
+
+    // decode hex text into vector
+    inline Binary::Bytes<Binary::HexEncoding> Hex(std::vector<uint8_t>& out)
+    {
+        return Binary::Bytes<Binary::HexEncoding>(out);
+    }
+
+    // decode hex text into caller provided buffer, length is set to number of bytes decoded.
+    inline Binary::Bytes<Binary::HexEncoding> Hex(uint8_t* data, size_t capacity, size_t& length)
+    {
+        return Binary::Bytes<Binary::HexEncoding>(data, capacity, length);
+    }
+
+    namespace Converters
+    {
+        // base64 or hex text of element or attribute into vector or caller provided buffer
+        template<typename TEncoding>
+        struct Converter<Binary::Bytes<TEncoding>>
+        {
+            template<typename TSource>
+            static void Convert(TSource& source, Binary::Bytes<TEncoding>& out)
+            {
+                out.Decode(source, detail::source_kind(source));
+            }
+        };
+    }
+}
@@ -0,0 +1,464 @@
+/*
+ * XmlTreeChrono.h
+ *
+ * Copyright (C) 2017 Daniel Nilsson
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#pragma once
+#include "XmlTree.h"
+
+#include <chrono>
+#include <cstring>
+#include <ratio>
+
+namespace XmlTree
+{
+    namespace detail
+    {
+        // parse exactly n digits
+        inline bool parse_digits(const char*& p, const char* end, int n, int& out)
+        {
+            if (end - p < n)
+            {
+                return false;
+            }
+
+            int v = 0;
+            for (int i = 0; i < n; ++i)
+            {
+                const unsigned d = static_cast<unsigned>(p[i] - '0');
+                if (d > 9)
+                {
+                    return false;
+                }
+
+                v = v * 10 + static_cast<int>(d);
+            }
+
+            p += n;
+            out = v;
+            return true;
+        }
+
+        // parse fraction digits after decimal point as nanoseconds, digits beyond 9 are truncated
+        inline bool parse_fraction(const char*& p, const char* end, int64_t& nanos)
+        {
+            const char* begin = p;
+
+            int64_t v = 0;
+            int digits = 0;
+            while (p != end && static_cast<unsigned>(*p - '0') <= 9)
+            {
+                if (digits < 9)
+                {
+                    v = v * 10 + (*p - '0');
+                    ++digits;
+                }
+
+                ++p;
+            }
+
+            for (; digits < 9; ++digits)
+            {
+                v *= 10;
+            }
+
+            nanos = v;
+            return p != begin;
+        }
+
+        // days since 1970-01-01 in proleptic gregorian calendar
+        inline int64_t days_from_civil(int64_t y, unsigned m, unsigned d)
+        {
+            y -= m <= 2;
+            const int64_t era = (y >= 0 ? y : y - 399) / 400;
+            const unsigned yoe = static_cast<unsigned>(y - era * 400);
+            const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+            const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+            return era * 146097 + static_cast<int64_t>(doe) - 719468;
+        }
+
+        inline int days_in_month(int y, int m)
+        {
+            static const int days[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+            const bool leap = (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+            return m == 2 && leap ? 29 : days[m - 1];
+        }
+
+        // ISO-8601 timestamp in extended format, YYYY-MM-DD[Thh:mm[:ss[.fff...]]][Z|+hh[:mm]|-hh[:mm]].
+        // Timestamps without offset are taken as UTC. A space may separate date and time.
+        // Result is seconds since the unix epoch and nanoseconds within that second.
+        inline bool parse_iso8601_time(const char* p, const char* end, int64_t& seconds, int64_t& nanos)
+        {
+            int year, month, day;
+            if (!parse_digits(p, end, 4, year) || p == end || *p++ != '-' ||
+                !parse_digits(p, end, 2, month) || p == end || *p++ != '-' ||
+                !parse_digits(p, end, 2, day))
+            {
+                return false;
+            }
+
+            if (month < 1 || month > 12 || day < 1 || day > days_in_month(year, month))
+            {
+                return false;
+            }
+
+            int hour = 0, minute = 0, second = 0;
+            nanos = 0;
+
+            if (p != end && (*p == 'T' || *p == 't' || *p == ' '))
+            {
+                ++p;
+                if (!parse_digits(p, end, 2, hour) || p == end || *p++ != ':' || !parse_digits(p, end, 2, minute))
+                {
+                    return false;
+                }
+
+                if (p != end && *p == ':')
+                {
+                    ++p;
+                    if (!parse_digits(p, end, 2, second))
+                    {
+                        return false;
+                    }
+
+                    if (p != end && (*p == '.' || *p == ','))
+                    {
+                        ++p;
+                        if (!parse_fraction(p, end, nanos))
+                        {
+                            return false;
+                        }
+                    }
+                }
+
+                // second 60 is accepted for leap seconds and rolls over into the next minute
+                if (hour > 23 || minute > 59 || second > 60)
+                {
+                    return false;
+                }
+            }
+
+            int offset = 0;
+            if (p != end && (*p == 'Z' || *p == 'z'))
+            {
+                ++p;
+            }
+            else if (p != end && (*p == '+' || *p == '-'))
+            {
+                const int sign = *p++ == '-' ? -1 : 1;
+
+                int offsetHours, offsetMinutes = 0;
+                if (!parse_digits(p, end, 2, offsetHours))
+                {
+                    return false;
+                }
+
+                // minutes are optional in +hh, but a colon must be followed by them
+                const bool colon = p != end && *p == ':';
+                if (colon)
+                {
+                    ++p;
+                }
+
+                if ((colon || p != end) && !parse_digits(p, end, 2, offsetMinutes))
+                {
+                    return false;
+                }
+
+                if (offsetHours > 23 || offsetMinutes > 59)
+                {
+                    return false;
+                }
+
+                offset = sign * (offsetHours * 3600 + offsetMinutes * 60);
+            }
+
+            if (p != end)
+            {
+                return false;
+            }
+
+            seconds = days_from_civil(year, static_cast<unsigned>(month), static_cast<unsigned>(day)) * 86400 +
+                hour * 3600 + minute * 60 + second - offset;
+            return true;
+        }
+
+        // ISO-8601 duration, [-]P[nW][nD][T[nH][nM][n[.fff...]S]]. Years and months are
+        // rejected as they have no fixed length. Result is magnitude in seconds and nanoseconds.
+        inline bool parse_iso8601_duration(const char* p, const char* end, bool& negative, int64_t& seconds, int64_t& nanos)
+        {
+            negative = p != end && *p == '-';
+            if (negative || (p != end && *p == '+'))
+            {
+                ++p;
+            }
+
+            if (p == end || (*p != 'P' && *p != 'p'))
+            {
+                return false;
+            }
+
+            ++p;
+
+            // designators in the order they may appear, seconds per unit
+            static const char units[] = { 'W', 'D', 'H', 'M', 'S' };
+            static const int64_t scale[] = { 604800, 86400, 3600, 60, 1 };
+            const int timeStart = 2;
+
+            seconds = 0;
+            nanos = 0;
+
+            bool time = false;
+            bool any = false;
+            int next = 0;
+
+            while (p != end)
+            {
+                if (*p == 'T' || *p == 't')
+                {
+                    if (time)
+                    {
+                        return false;
+                    }
+
+                    time = true;
+                    next = timeStart;
+                    ++p;
+                    continue;
+                }
+
+                const char* begin = p;
+                int64_t value = 0;
+                while (p != end && static_cast<unsigned>(*p - '0') <= 9)
+                {
+                    if (value > (INT64_MAX - 9) / 10)
+                    {
+                        return false;
+                    }
+
+                    value = value * 10 + (*p++ - '0');
+                }
+
+                int64_t fraction = 0;
+                if (p != end && (*p == '.' || *p == ',') && p != begin)
+                {
+                    ++p;
+                    if (!parse_fraction(p, end, fraction))
+                    {
+                        return false;
+                    }
+                }
+
+                if (p == begin || p == end)
+                {
+                    return false;
+                }
+
+                const char designator = static_cast<char>(*p >= 'a' && *p <= 'z' ? *p - 'a' + 'A' : *p);
+                ++p;
+
+                int unit = next;
+                while (unit < 5 && units[unit] != designator)
+                {
+                    ++unit;
+                }
+
+                // W and D before T, H M S after
+                if (unit == 5 || (time != (unit >= timeStart)))
+                {
+                    return false;
+                }
+
+                // only the smallest unit given may carry a fraction
+                if (fraction != 0 && p != end)
+                {
+                    return false;
+                }
+
+                if (value > INT64_MAX / scale[unit] - seconds / scale[unit] - 1)
+                {
+                    return false;
+                }
+
+                seconds += value * scale[unit];
+                if (fraction != 0)
+                {
+                    // fraction of unit in nanoseconds, split into whole seconds and rest
+                    const int64_t total = fraction * scale[unit];
+                    seconds += total / 1000000000;
+                    nanos = total % 1000000000;
+                }
+
+                next = unit + 1;
+                any = true;
+            }
+
+            // "T" must be followed by at least one time component
+            return any && (!time || next > timeStart);
+        }
+
+        // floating point rep, nothing to overflow
+        template<typename TDuration>
+        bool to_duration(int64_t seconds, int64_t nanos, bool negative, TDuration& out, std::true_type)
+        {
+            out = std::chrono::duration_cast<TDuration>(std::chrono::seconds(seconds)) +
+                std::chrono::duration_cast<TDuration>(std::chrono::nanoseconds(nanos));
+
+            if (negative)
+            {
+                out = -out;
+            }
+
+            return true;
+        }
+
+        // integral rep, ticks are computed in int64_t and checked against the range of the rep
+        template<typename TDuration>
+        bool to_duration(int64_t seconds, int64_t nanos, bool negative, TDuration& out, std::false_type)
+        {
+            typedef std::chrono::duration<int64_t, typename TDuration::period> ticks_type;
+            typedef std::ratio_divide<std::ratio<1>, typename TDuration::period> per_second;
+
+            // the lowest value has seconds one past -limit and a positive fraction, borrow a second
+            const int64_t limit = INT64_MAX / per_second::num;
+            if (seconds == -limit - 1 && nanos > 0)
+            {
+                ++seconds;
+                nanos -= 1000000000;
+            }
+
+            if (seconds > limit || seconds < -limit)
+            {
+                return false;
+            }
+
+            const int64_t whole = std::chrono::duration_cast<ticks_type>(std::chrono::seconds(seconds)).count();
+            const int64_t part = std::chrono::duration_cast<ticks_type>(std::chrono::nanoseconds(nanos)).count();
+            if (part >= 0 ? whole > INT64_MAX - part : whole < INT64_MIN - part)
+            {
+                return false;
+            }
+
+            const int64_t ticks = negative ? -(whole + part) : whole + part;
+            if (ticks < 0)
+            {
+                if (!std::is_signed<typename TDuration::rep>::value || ticks < static_cast<int64_t>(TDuration::min().count()))
+                {
+                    return false;
+                }
+            }
+            else if (static_cast<uint64_t>(ticks) > static_cast<uint64_t>(TDuration::max().count()))
+            {
+                return false;
+            }
+
+            out = TDuration(static_cast<typename TDuration::rep>(ticks));
+            return true;
+        }
+
+        // seconds and nanoseconds to TDuration, false if the value does not fit
+        template<typename TDuration>
+        bool to_duration(int64_t seconds, int64_t nanos, bool negative, TDuration& out)
+        {
+            return to_duration(seconds, nanos, negative, out, std::is_floating_point<typename TDuration::rep>());
+        }
+
+        template<typename TSource>
+        void throw_time_range_error(TSource& source, const char* kind, const char* begin, const char* end)
+        {
+            throw std::runtime_error("'" + std::string(begin, end) + "' in " + kind + " '" + source.Name() + "' is out of range.");
+        }
+
+        template<typename TSource, typename TDuration>
+        void convert_time(TSource& source, const char* kind, std::chrono::time_point<std::chrono::system_clock, TDuration>& out)
+        {
+            const char* begin = source.RawValue();
+            const char* end = begin + std::strlen(begin);
+            while (begin != end && is_space(*begin))
+            {
+                ++begin;
+            }
+
+            while (end != begin && is_space(end[-1]))
+            {
+                --end;
+            }
+
+            int64_t seconds;
+            int64_t nanos;
+            if (!parse_iso8601_time(begin, end, seconds, nanos))
+            {
+                throw std::runtime_error("'" + std::string(begin, end) + "' in " + kind + " '" + source.Name() + "' is not a valid ISO-8601 timestamp.");
+            }
+
+            TDuration since;
+            if (!to_duration(seconds, nanos, false, since))
+            {
+                throw_time_range_error(source, kind, begin, end);
+            }
+
+            out = std::chrono::time_point<std::chrono::system_clock, TDuration>(since);
+        }
+
+        template<typename TSource, typename TRep, typename TPeriod>
+        void convert_duration(TSource& source, const char* kind, std::chrono::duration<TRep, TPeriod>& out)
+        {
+            const char* begin = source.RawValue();
+            const char* end = begin + std::strlen(begin);
+            while (begin != end && is_space(*begin))
+            {
+                ++begin;
+            }
+
+            while (end != begin && is_space(end[-1]))
+            {
+                --end;
+            }
+
+            bool negative;
+            int64_t seconds;
+            int64_t nanos;
+            if (!parse_iso8601_duration(begin, end, negative, seconds, nanos))
+            {
+                throw std::runtime_error("'" + std::string(begin, end) + "' in " + kind + " '" + source.Name() + "' is not a valid ISO-8601 duration.");
+            }
+
+            if (!to_duration(seconds, nanos, negative, out))
+            {
+                throw_time_range_error(source, kind, begin, end);
+            }
+        }
+    }
+
+    namespace Converters
+    {
+        // std::chrono::system_clock::time_point and std::chrono::sys_time of any precision
+        // from ISO-8601 timestamp, e.g. 2018-01-18T14:05:32.250+01:00. Fraction digits beyond
+        // the precision of the time point are dropped. Timestamps outside the range of the time point
+        // throw, with nanosecond precision that is years 1678 to 2261.
+        template<typename TDuration>
+        struct Converter<std::chrono::time_point<std::chrono::system_clock, TDuration>>
+        {
+            template<typename TSource>
+            static void Convert(TSource& source, std::chrono::time_point<std::chrono::system_clock, TDuration>& out)
+            {
+                detail::convert_time(source, detail::source_kind(source), out);
+            }
+        };
+
+        // std::chrono::duration from ISO-8601 duration, e.g. PT1.5S or P1DT12H, throws if it does not fit the rep
+        template<typename TRep, typename TPeriod>
+        struct Converter<std::chrono::duration<TRep, TPeriod>>
+        {
+            template<typename TSource>
+            static void Convert(TSource& source, std::chrono::duration<TRep, TPeriod>& out)
+            {
+                detail::convert_duration(source, detail::source_kind(source), out);
+            }
+        };
+    }
+}
@@ -0,0 +1,733 @@
+/*
+ * XmlTreeStream.h
+ *
+ * Copyright (C) 2017 Daniel Nilsson
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+#pragma once
+#include "XmlTree.h"
+
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <cstdio>
+#include <memory>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace XmlTree
+{
+    namespace detail
+    {
+        // Incremental scanner locating complete elements at a given path in a stream
+        // of xml text that arrives in pieces. Every byte is examined once, a partial
+        // tag at the end of the data is examined again when more data is available.
+        // Comments, CDATA sections, processing instructions and DOCTYPE are skipped.
+        class ElementScanner
+        {
+        public:
+            static const size_t npos = static_cast<size_t>(-1);
+
+            // path of element names from document level, e.g. { "notes", "note" }
+            explicit ElementScanner(const std::vector<std::string>& path)
+                : _path(path)
+            {
+                Reset();
+            }
+
+            void Reset()
+            {
+                _pos = 0;
+                _start = npos;
+                _depth = 0;
+                _matched = 0;
+            }
+
+            // scan data up to size, returns true when a complete element was found and sets
+            // [begin, end) to its range. Returns false when more data is needed.
+            bool Next(const char* data, size_t size, size_t& begin, size_t& end)
+            {
+                while (_pos < size)
+                {
+                    auto lt = static_cast<const char*>(std::memchr(data + _pos, '<', size - _pos));
+                    if (lt == nullptr)
+                    {
+                        _pos = size;
+                        return false;
+                    }
+
+                    _pos = lt - data;
+                    if (_pos + 1 >= size)
+                    {
+                        return false;
+                    }
+
+                    size_t tagEnd;
+                    const char c = data[_pos + 1];
+                    if (c == '?')
+                    {
+                        tagEnd = Find(data, size, _pos + 2, "?>");
+                    }
+                    else if (c == '!')
+                    {
+                        tagEnd = SkipMarkup(data, size);
+                    }
+                    else if (c == '/')
+                    {
+                        tagEnd = Find(data, size, _pos + 2, ">");
+                        if (tagEnd != npos && CloseTag(begin, end, tagEnd))
+                        {
+                            _pos = tagEnd;
+                            return true;
+                        }
+                    }
+                    else
+                    {
+                        tagEnd = FindTagEnd(data, size, _pos + 1);
+                        if (tagEnd != npos && OpenTag(data, tagEnd, begin, end))
+                        {
+                            _pos = tagEnd;
+                            return true;
+                        }
+                    }
+
+                    if (tagEnd == npos)
+                    {
+                        return false;
+                    }
+
+                    _pos = tagEnd;
+                }
+
+                return false;
+            }
+
+            // first n bytes of data have been dropped by the caller
+            void Discard(size_t n)
+            {
+                _pos -= n;
+                if (_start != npos)
+                {
+                    _start -= n;
+                }
+            }
+
+            // start of element currently being scanned, npos if none
+            size_t Pending() const
+            {
+                return _start;
+            }
+
+            // offset of first byte not yet scanned
+            size_t Position() const
+            {
+                return _pos;
+            }
+
+        private:
+            // returns offset after terminator or npos
+            static size_t Find(const char* data, size_t size, size_t from, const char* terminator)
+            {
+                const size_t len = std::strlen(terminator);
+                for (size_t i = from; i + len <= size; ++i)
+                {
+                    if (data[i] == terminator[0] && std::memcmp(data + i, terminator, len) == 0)
+                    {
+                        return i + len;
+                    }
+                }
+
+                return npos;
+            }
+
+            // returns offset after closing '>' of tag, ignoring '>' inside quoted attribute values
+            static size_t FindTagEnd(const char* data, size_t size, size_t from)
+            {
+                char quote = 0;
+                for (size_t i = from; i < size; ++i)
+                {
+                    const char c = data[i];
+                    if (quote != 0)
+                    {
+                        if (c == quote)
+                        {
+                            quote = 0;
+                        }
+                    }
+                    else if (c == '"' || c == '\'')
+                    {
+                        quote = c;
+                    }
+                    else if (c == '>')
+                    {
+                        return i + 1;
+                    }
+                }
+
+                return npos;
+            }
+
+            // skips comment, CDATA section or DOCTYPE, returns offset after it or npos
+            size_t SkipMarkup(const char* data, size_t size) const
+            {
+                static const char cdata[] = "<![CDATA[";
+                const size_t avail = size - _pos;
+
+                if (avail < 4)
+                {
+                    return npos;
+                }
+
+                if (std::memcmp(data + _pos, "<!--", 4) == 0)
+                {
+                    return Find(data, size, _pos + 4, "-->");
+                }
+
+                if (std::memcmp(data + _pos, cdata, std::min<size_t>(avail, 9)) == 0)
+                {
+                    return avail < 9 ? npos : Find(data, size, _pos + 9, "]]>");
+                }
+
+                // DOCTYPE, may contain an internal subset in brackets
+                int brackets = 0;
+                for (size_t i = _pos + 2; i < size; ++i)
+                {
+                    if (data[i] == '[')
+                    {
+                        ++brackets;
+                    }
+                    else if (data[i] == ']')
+                    {
+                        --brackets;
+                    }
+                    else if (data[i] == '>' && brackets <= 0)
+                    {
+                        return i + 1;
+                    }
+                }
+
+                return npos;
+            }
+
+            bool NameIs(const char* name, const std::string& expected) const
+            {
+                const size_t len = expected.size();
+                if (std::memcmp(name, expected.data(), len) != 0)
+                {
+                    return false;
+                }
+
+                const char c = name[len];
+                return c == '>' || c == '/' || c == ' ' || c == '\t' || c == '\r' || c == '\n';
+            }
+
+            bool OpenTag(const char* data, size_t tagEnd, size_t& begin, size_t& end)
+            {
+                const bool selfClosing = data[tagEnd - 2] == '/';
+                const bool match = _matched == _depth && _depth < _path.size() &&
+                    tagEnd - _pos - 1 > _path[_depth].size() && NameIs(data + _pos + 1, _path[_depth]);
+
+                if (match && _depth + 1 == _path.size())
+                {
+                    if (selfClosing)
+                    {
+                        begin = _pos;
+                        end = tagEnd;
+                        return true;
+                    }
+
+                    _start = _pos;
+                }
+
+                if (!selfClosing)
+                {
+                    ++_depth;
+                    if (match)
+                    {
+                        _matched = _depth;
+                    }
+                }
+
+                return false;
+            }
+
+            bool CloseTag(size_t& begin, size_t& end, size_t tagEnd)
+            {
+                if (_depth == 0)
+                {
+                    return false;
+                }
+
+                const bool complete = _start != npos && _matched == _path.size() && _depth == _path.size();
+
+                --_depth;
+                if (_matched > _depth)
+                {
+                    _matched = _depth;
+                }
+
+                if (complete)
+                {
+                    begin = _start;
+                    end = tagEnd;
+                    _start = npos;
+                    return true;
+                }
+
+                return false;
+            }
+
+            std::vector<std::string> _path;
+            size_t _pos;
+            size_t _start;
+            size_t _depth;
+            size_t _matched;
+        };
+
+        // split "notes/note" into { "notes", "note" }
+        inline std::vector<std::string> split_path(const std::string& path)
+        {
+            std::vector<std::string> res;
+
+            size_t begin = 0;
+            while (begin <= path.size())
+            {
+                auto end = path.find('/', begin);
+                if (end == std::string::npos)
+                {
+                    end = path.size();
+                }
+
+                if (end > begin)
+                {
+                    res.push_back(path.substr(begin, end - begin));
+                }
+
+                begin = end + 1;
+            }
+
+            if (res.empty())
+            {
+                throw std::runtime_error("Invalid element path '" + path + "'.");
+            }
+
+            return res;
+        }
+
+        // Reads a file in chunks and returns the complete elements found at a path one
+        // at a time. Memory use is bounded by the largest element, not the file size.
+        class FileElementReader
+        {
+        public:
+            FileElementReader(const std::string& filePath, const std::string& elementPath, size_t bufferSize)
+                : _file(std::fopen(filePath.c_str(), "rb"), &std::fclose), _path(elementPath), _buffer(bufferSize > 0 ? bufferSize : 1),
+                  _begin(0), _end(0), _offset(0), _consumed(0), _scanner(split_path(elementPath))
+            {
+                if (!_file)
+                {
+                    throw std::runtime_error("Failed to open file '" + filePath + "'.");
+                }
+            }
+
+            // next complete element, returns false at end of file
+            bool Next(const char*& data, size_t& size)
+            {
+                size_t begin;
+                size_t end;
+                while (!_scanner.Next(_buffer.data(), _end, begin, end))
+                {
+                    if (!Fill())
+                    {
+                        if (_scanner.Pending() != ElementScanner::npos)
+                        {
+                            throw std::runtime_error("File ended in the middle of element '" + _path + "'.");
+                        }
+
+                        return false;
+                    }
+                }
+
+                data = _buffer.data() + begin;
+                size = end - begin;
+
+                _begin = end;
+                _consumed = _offset + end;
+                return true;
+            }
+
+            // bytes of file up to and including the last element returned
+            size_t Consumed() const
+            {
+                return _consumed;
+            }
+
+        private:
+            bool Fill()
+            {
+                // keep partial element, or unscanned partial tag, at start of buffer
+                size_t keep = _scanner.Pending() != ElementScanner::npos ? _scanner.Pending() : std::min(_scanner.Position(), _end);
+                if (keep < _begin)
+                {
+                    keep = _begin;
+                }
+
+                if (keep > 0)
+                {
+                    std::memmove(_buffer.data(), _buffer.data() + keep, _end - keep);
+                    _scanner.Discard(keep);
+                    _offset += keep;
+                    _end -= keep;
+                    _begin = 0;
+                }
+
+                if (_end == _buffer.size())
+                {
+                    _buffer.resize(_buffer.size() * 2);
+                }
+
+                auto n = std::fread(_buffer.data() + _end, 1, _buffer.size() - _end, _file.get());
+                if (n == 0 && std::ferror(_file.get()))
+                {
+                    throw std::runtime_error("Failed to read file: " + std::string(std::strerror(errno)));
+                }
+
+                _end += n;
+                return n > 0;
+            }
+
+            std::unique_ptr<std::FILE, int(*)(std::FILE*)> _file;
+            std::string _path;
+            std::vector<char> _buffer;
+            size_t _begin;
+            size_t _end;
+            size_t _offset;
+            size_t _consumed;
+            ElementScanner _scanner;
+        };
+    }
+
+    // Read file in chunks and convert each element at path (e.g. "notes/note") to T, calling
+    // func(T&) for each. Only one element is parsed at a time, so neither the whole file nor
+    // its DOM is ever held in memory. Returns number of elements read.
+    template<typename T, typename TFunc>
+    size_t ReadEach(const std::string& filePath, const std::string& elementPath, TFunc&& func, const Options& options = Options(), size_t bufferSize = 64 * 1024)
+    {
+        detail::FileElementReader reader(filePath, elementPath, bufferSize);
+        const auto name = detail::split_path(elementPath).back();
+
+        tinyxml2::XMLDocument doc(options.processEntities, detail::document_whitespace(options.whitespace));
+        size_t count = 0;
+
+        const char* data;
+        size_t size;
+        while (reader.Next(data, size))
+        {
+            if (tinyxml2::XML_SUCCESS != doc.Parse(data, size))
+            {
+                throw std::runtime_error(doc.ErrorStr());
+            }
+
+            T res;
+            Element(doc.FirstChildElement(name.c_str())).Convert(res);
+            func(res);
+            ++count;
+        }
+
+        return count;
+    }
+
+    // Read file in chunks and convert each element at path (e.g. "notes/note") into container,
+    // see Element::ConvertRepeated. Peak memory is the bound result plus the largest element
+    // instead of the result plus the whole file and its DOM, build/memory_benchmark.py measures it.
+    template<typename TContainer>
+    void ReadRepeated(const std::string& filePath, const std::string& elementPath, TContainer& out, const Options& options = Options(), size_t bufferSize = 64 * 1024)
+    {
+        detail::FileElementReader reader(filePath, elementPath, bufferSize);
+        const auto name = detail::split_path(elementPath).back();
+
+        tinyxml2::XMLDocument doc(options.processEntities, detail::document_whitespace(options.whitespace));
+
+        const char* data;
+        size_t size;
+        while (reader.Next(data, size))
+        {
+            if (tinyxml2::XML_SUCCESS != doc.Parse(data, size))
+            {
+                throw std::runtime_error(doc.ErrorStr());
+            }
+
+            detail::sequence_sink<TContainer>::append(out, Element(doc.FirstChildElement(name.c_str())));
+        }
+    }
+
+    // Read file only up to the first element at path (e.g. "page/info") and convert it to T.
+    // Reading stops as soon as the element is complete, so the cost depends on where the
+    // element is in the file and not on the file size. Bytes read up to and including the
+    // element are stored in bytesConsumed if given.
+    template<typename T>
+    T ReadPrefix(const std::string& filePath, const std::string& elementPath, size_t* bytesConsumed = nullptr, const Options& options = Options(), size_t bufferSize = 4 * 1024)
+    {
+        detail::FileElementReader reader(filePath, elementPath, bufferSize);
+
+        const char* data;
+        size_t size;
+        if (!reader.Next(data, size))
+        {
+            throw std::runtime_error("Element '" + elementPath + "' not found.");
+        }
+
+        tinyxml2::XMLDocument doc(options.processEntities, detail::document_whitespace(options.whitespace));
+        if (tinyxml2::XML_SUCCESS != doc.Parse(data, size))
+        {
+            throw std::runtime_error(doc.ErrorStr());
+        }
+
+        if (bytesConsumed != nullptr)
+        {
+            *bytesConsumed = reader.Consumed();
+        }
+
+        T res;
+        Element(doc.FirstChildElement()).Convert(res);
+        return res;
+    }
+
+    // Reads a continuous stream of xml messages from a file descriptor (pipe, socket...)
+    // and binds each message to T. Messages are framed either by the closing tag of
+    // their root element or by a 4 byte big endian length prefix. The read buffer and
+    // tinyxml2 document are reused between messages. A message larger than maxMessageSize,
+    // by its length prefix or by the bytes buffered without finding its end, throws and
+    // the stream cannot be read further as its framing is lost.
+    template<typename T>
+    class MessageReader
+    {
+    public:
+        enum class Framing { RootElement, LengthPrefix };
+
+        struct Message
+        {
+            // sequence number of message in stream, starting at 0
+            size_t index;
+
+            // size of message in bytes, excluding length prefix
+            size_t bytes;
+
+            // time from the message being fully received until it was bound
+            std::chrono::steady_clock::duration latency;
+        };
+
+        MessageReader(int fd, const std::string& rootElement, Framing framing = Framing::RootElement, const Options& options = Options(), size_t bufferSize = 64 * 1024,
+                      size_t maxMessageSize = 16 * 1024 * 1024)
+            : _fd(fd), _rootElement(rootElement), _framing(framing), _maxMessageSize(maxMessageSize), _buffer(bufferSize > 0 ? bufferSize : 1),
+              _begin(0), _end(0), _eof(false), _index(0), _scanner(std::vector<std::string>(1, rootElement)),
+              _doc(options.processEntities, detail::document_whitespace(options.whitespace))
+        {
+        }
+
+        // read and bind next message, returns false at end of stream
+        bool Next(T& out, Message* info = nullptr)
+        {
+            size_t begin;
+            size_t end;
+            if (!NextFrame(begin, end))
+            {
+                return false;
+            }
+
+            // the frame is consumed even if it fails to parse or bind, so a bad
+            // message is skipped and the next call continues with the one after it
+            _begin = end;
+            const size_t index = _index++;
+
+            if (tinyxml2::XML_SUCCESS != _doc.Parse(_buffer.data() + begin, end - begin))
+            {
+                throw std::runtime_error(_doc.ErrorStr());
+            }
+
+            auto root = _doc.FirstChildElement(_rootElement.c_str());
+            if (root == nullptr)
+            {
+                throw std::runtime_error("Root element '" + _rootElement + "' not found.");
+            }
+
+            T res;
+            Element(root).Convert(res);
+            out = std::move(res);
+
+            if (info != nullptr)
+            {
+                info->index = index;
+                info->bytes = end - begin;
+                info->latency = std::chrono::steady_clock::now() - _received;
+            }
+
+            return true;
+        }
+
+        // read and bind messages until end of stream calling func(T&, const Message&)
+        // for each, returns number of messages read.
+        template<typename TFunc>
+        size_t Run(TFunc&& func)
+        {
+            size_t count = 0;
+
+            T message;
+            Message info;
+            while (Next(message, &info))
+            {
+                func(message, static_cast<const Message&>(info));
+                ++count;
+            }
+
+            return count;
+        }
+
+    private:
+        bool NextFrame(size_t& begin, size_t& end)
+        {
+            if (_framing == Framing::LengthPrefix)
+            {
+                while (_end - _begin < 4)
+                {
+                    if (!Fill())
+                    {
+                        return false;
+                    }
+                }
+
+                auto p = reinterpret_cast<const unsigned char*>(_buffer.data() + _begin);
+                const size_t length = (size_t(p[0]) << 24) | (size_t(p[1]) << 16) | (size_t(p[2]) << 8) | size_t(p[3]);
+                if (length > _maxMessageSize)
+                {
+                    throw std::runtime_error("Message of " + std::to_string(length) + " bytes exceeds maximum message size of " +
+                        std::to_string(_maxMessageSize) + " bytes.");
+                }
+
+                while (_end - _begin < 4 + length)
+                {
+                    if (!Fill())
+                    {
+                        return false;
+                    }
+                }
+
+                begin = _begin + 4;
+                end = begin + length;
+                return true;
+            }
+
+            while (!_scanner.Next(_buffer.data(), _end, begin, end))
+            {
+                // no complete message in what is buffered, the pending one is larger still
+                if (_end - _begin >= _maxMessageSize)
+                {
+                    throw std::runtime_error("No complete '" + _rootElement + "' message within maximum message size of " +
+                        std::to_string(_maxMessageSize) + " bytes.");
+                }
+
+                if (!Fill())
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        // read more data into buffer, returns false at end of stream
+        bool Fill()
+        {
+            if (_eof)
+            {
+                return false;
+            }
+
+            if (_begin > 0)
+            {
+                // drop consumed messages, keep partial message at start of buffer
+                std::memmove(_buffer.data(), _buffer.data() + _begin, _end - _begin);
+                if (_framing == Framing::RootElement)
+                {
+                    _scanner.Discard(_begin);
+                }
+
+                _end -= _begin;
+                _begin = 0;
+            }
+
+            if (_end == _buffer.size())
+            {
+                _buffer.resize(_buffer.size() * 2);
+            }
+
+            for (;;)
+            {
+#ifdef _WIN32
+                auto n = ::_read(_fd, _buffer.data() + _end, static_cast<unsigned int>(_buffer.size() - _end));
+#else
+                auto n = ::read(_fd, _buffer.data() + _end, _buffer.size() - _end);
+#endif
+                if (n < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+
+                if (n < 0)
+                {
+                    throw std::runtime_error(std::string("Failed to read message stream: ") + std::strerror(errno));
+                }
+
+                if (n == 0)
+                {
+                    _eof = true;
+                    CheckTrailing();
+                    return false;
+                }
+
+                _received = std::chrono::steady_clock::now();
+                _end += static_cast<size_t>(n);
+                return true;
+            }
+        }
+
+        // stream may only end between messages
+        void CheckTrailing() const
+        {
+            bool partial = _scanner.Pending() != detail::ElementScanner::npos || (_framing == Framing::LengthPrefix && _end > _begin);
+            if (!partial && _framing == Framing::RootElement)
+            {
+                // unscanned bytes after the last message, e.g. an incomplete tag
+                for (size_t i = _scanner.Position(); i < _end && !partial; ++i)
+                {
+                    const char c = _buffer[i];
+                    partial = c != ' ' && c != '\t' && c != '\r' && c != '\n';
+                }
+            }
+
+            if (partial)
+            {
+                throw std::runtime_error("Message stream ended in the middle of a message.");
+            }
+        }
+
+        int _fd;
+        std::string _rootElement;
+        Framing _framing;
+        size_t _maxMessageSize;
+        std::vector<char> _buffer;
+        size_t _begin;
+        size_t _end;
+        bool _eof;
+        size_t _index;
+        std::chrono::steady_clock::time_point _received;
+        detail::ElementScanner _scanner;
+        tinyxml2::XMLDocument _doc;
+    };
+}
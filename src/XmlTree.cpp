@@ -0,0 +1,20 @@
+/*
+ * XmlTree.cpp
+ *
+ * Copyright (C) 2017 Daniel Nilsson
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE file for details.
+ */
+
+// Built-in value converters for builds with XMLTREE_COMPILED defined project wide, see
+// XmlTree.h. Compiles to nothing when XMLTREE_COMPILED is not defined.
+#define XMLTREE_IMPLEMENTATION
+#include "XmlTree.h"
+
+#ifdef XMLTREE_COMPILED
+namespace XmlTree
+{
+    XMLTREE_FOR_EACH_VALUE_TYPE(XMLTREE_INSTANTIATE_VALUE_CONVERTER)
+}
+#endif
\ No newline at end of file